@@ -0,0 +1,867 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <slot_map.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+  Standalone slot_map microbenchmarks.
+
+  Usage: SlotMapBench [--n=<number of elements>] [--filter=<substring>] [--csv] [--perf]
+
+  Every operation is timed in batches of kBatchSize calls. `ns/op` is the total time divided by the total number of calls,
+  p50/p99 are percentiles of the per-batch averages (timing every single call would mostly measure the clock itself).
+  Peak RSS is the process high-water mark after the case has finished (on Linux it is reset before every case).
+
+  --perf (Linux only) additionally samples hardware performance counters via perf_event_open and reports cache misses,
+  dTLB load misses, branch mispredicts and retired instructions per operation (user space only, the timer calls are included).
+  Requires /proc/sys/kernel/perf_event_paranoid <= 2 (or CAP_PERFMON).
+
+  Note: build in Release, Debug numbers are meaningless.
+*/
+
+namespace
+{
+
+static const size_t kBatchSize = 256;
+static volatile uint64_t gSink = 0;
+
+struct Options
+{
+    size_t numElements = 500000;
+    const char* filter = nullptr;
+    bool csv = false;
+    bool perf = false;
+};
+
+struct PerfSample
+{
+    bool valid = false;
+    uint64_t cacheMisses = 0;
+    uint64_t dtlbMisses = 0;
+    uint64_t branchMisses = 0;
+    uint64_t instructions = 0;
+};
+
+// Hardware performance counters (a single perf_event_open group, so all the counters are scheduled together)
+class PerfCounters
+{
+  public:
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters() { close(); }
+
+#if defined(__linux__)
+    bool open()
+    {
+        const uint64_t dtlbReadMiss = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const uint32_t types[kNumCounters] = {PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+        const uint64_t configs[kNumCounters] = {PERF_COUNT_HW_CACHE_MISSES, dtlbReadMiss, PERF_COUNT_HW_BRANCH_MISSES,
+                                                PERF_COUNT_HW_INSTRUCTIONS};
+        for (int i = 0; i < kNumCounters; i++)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = (i == 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : fds[0], 0));
+            if (fds[i] < 0)
+            {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void start()
+    {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    PerfSample stop()
+    {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        struct
+        {
+            uint64_t nr;
+            uint64_t values[kNumCounters];
+        } data;
+
+        PerfSample res;
+        if (read(fds[0], &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data.nr != kNumCounters)
+        {
+            return res;
+        }
+        res.valid = true;
+        res.cacheMisses = data.values[0];
+        res.dtlbMisses = data.values[1];
+        res.branchMisses = data.values[2];
+        res.instructions = data.values[3];
+        return res;
+    }
+
+    void close()
+    {
+        for (int i = kNumCounters - 1; i >= 0; i--)
+        {
+            if (fds[i] >= 0)
+            {
+                ::close(fds[i]);
+                fds[i] = -1;
+            }
+        }
+    }
+#else
+    bool open() { return false; }
+    void start() {}
+    PerfSample stop() { return PerfSample(); }
+    void close() {}
+#endif
+
+    bool isOpen() const { return fds[0] >= 0; }
+
+  private:
+    static const int kNumCounters = 4;
+    int fds[kNumCounters] = {-1, -1, -1, -1};
+};
+
+struct Payload64
+{
+    uint64_t data[8] = {};
+
+    Payload64() = default;
+    explicit Payload64(uint64_t v) { data[0] = v; }
+};
+
+inline uint64_t toU64(int v) { return static_cast<uint64_t>(v); }
+inline uint64_t toU64(const Payload64& v) { return v.data[0]; }
+
+template <typename T> const char* valueTypeName();
+template <> const char* valueTypeName<int>() { return "int"; }
+template <> const char* valueTypeName<Payload64>() { return "Payload64"; }
+
+void resetPeakRss()
+{
+#if defined(__linux__)
+    // writing "5" to clear_refs resets the peak RSS (VmHWM) to the current RSS
+    if (FILE* f = fopen("/proc/self/clear_refs", "w"))
+    {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+double getPeakRssMb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return double(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#elif defined(__linux__)
+    double res = 0.0;
+    if (FILE* f = fopen("/proc/self/status", "r"))
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            unsigned long kb = 0;
+            if (sscanf(line, "VmHWM: %lu kB", &kb) == 1)
+            {
+                res = double(kb) / 1024.0;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    return res;
+#else
+    // macOS reports ru_maxrss in bytes
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_maxrss) / (1024.0 * 1024.0);
+#endif
+}
+
+class Reporter
+{
+  public:
+    explicit Reporter(const Options& _opts)
+        : opts(_opts)
+    {
+        if (opts.perf && !perf.open())
+        {
+            fprintf(stderr, "Warning: hardware performance counters are not available (perf_event_open failed)\n");
+        }
+    }
+
+    void startPerf()
+    {
+        if (perf.isOpen())
+        {
+            perf.start();
+        }
+    }
+
+    PerfSample stopPerf() { return perf.isOpen() ? perf.stop() : PerfSample(); }
+
+    bool isEnabled(const std::string& container, const char* op) const
+    {
+        if (opts.filter == nullptr)
+        {
+            return true;
+        }
+        return container.find(opts.filter) != std::string::npos || strstr(op, opts.filter) != nullptr;
+    }
+
+    void printHeader() const
+    {
+        if (opts.csv)
+        {
+            printf("container,operation,ns_per_op,p50_ns,p99_ns,peak_rss_mb%s\n",
+                   perf.isOpen() ? ",cache_misses_per_op,dtlb_misses_per_op,branch_misses_per_op,instructions_per_op" : "");
+        }
+        else
+        {
+            printf("%-36s %-22s %10s %10s %10s %14s", "container", "operation", "ns/op", "p50", "p99", "peak RSS (MB)");
+            if (perf.isOpen())
+            {
+                printf(" %10s %10s %10s %10s", "LLC/op", "dTLB/op", "brmiss/op", "instr/op");
+            }
+            printf("\n");
+        }
+    }
+
+    void report(const std::string& container, const char* op, size_t numOps, double nsPerOp, double p50, double p99, double peakRssMb,
+                const PerfSample& sample) const
+    {
+        if (opts.csv)
+        {
+            printf("%s,%s,%.3f,%.3f,%.3f,%.2f", container.c_str(), op, nsPerOp, p50, p99, peakRssMb);
+        }
+        else
+        {
+            printf("%-36s %-22s %10.2f %10.2f %10.2f %14.2f", container.c_str(), op, nsPerOp, p50, p99, peakRssMb);
+        }
+
+        if (perf.isOpen())
+        {
+            double ops = double(std::max(numOps, size_t(1)));
+            double values[4] = {double(sample.cacheMisses) / ops, double(sample.dtlbMisses) / ops, double(sample.branchMisses) / ops,
+                                double(sample.instructions) / ops};
+            for (double v : values)
+            {
+                if (!sample.valid)
+                {
+                    printf(opts.csv ? "," : " %10s", "n/a");
+                }
+                else if (opts.csv)
+                {
+                    printf(",%.3f", v);
+                }
+                else
+                {
+                    printf(" %10.3f", v);
+                }
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    const Options& opts;
+
+  private:
+    PerfCounters perf;
+};
+
+// Times `body(begin, end)` over [0..numOps) in batches and reports ns/op, p50 and p99
+template <typename FUNC> void measure(Reporter& reporter, const std::string& container, const char* op, size_t numOps, FUNC&& body)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<double> samples;
+    samples.reserve(numOps / kBatchSize + 1);
+
+    double totalNs = 0.0;
+    reporter.startPerf();
+    for (size_t begin = 0; begin < numOps; begin += kBatchSize)
+    {
+        size_t end = std::min(begin + kBatchSize, numOps);
+        auto t0 = clock::now();
+        body(begin, end);
+        auto t1 = clock::now();
+        double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        totalNs += ns;
+        samples.push_back(ns / double(end - begin));
+    }
+    PerfSample sample = reporter.stopPerf();
+
+    if (samples.empty())
+    {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    double p50 = samples[(samples.size() - 1) / 2];
+    double p99 = samples[std::min(samples.size() - 1, (samples.size() * 99) / 100)];
+    reporter.report(container, op, numOps, totalNs / double(numOps), p50, p99, getPeakRssMb(), sample);
+}
+
+// Times a single call of `body` that touches `numElements` elements and reports ns/element
+template <typename FUNC> void measureOnce(Reporter& reporter, const std::string& container, const char* op, size_t numElements, FUNC&& body)
+{
+    using clock = std::chrono::steady_clock;
+    reporter.startPerf();
+    auto t0 = clock::now();
+    body();
+    auto t1 = clock::now();
+    PerfSample sample = reporter.stopPerf();
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()) / double(std::max(numElements, size_t(1)));
+    reporter.report(container, op, numElements, ns, ns, ns, getPeakRssMb(), sample);
+}
+
+template <typename MAP, typename T> std::string slotMapName()
+{
+    char buf[128];
+    const char* layout = std::is_same<typename MAP::layout, dod::slot_map_layout_interleaved>::value  ? ", interleaved"
+                         : std::is_same<typename MAP::layout, dod::slot_map_layout_dense_meta>::value ? ", dense meta"
+                         : std::is_same<typename MAP::layout, dod::slot_map_layout_contiguous>::value ? ", contiguous"
+                                                                                                      : "";
+    snprintf(buf, sizeof(buf), "slot_map%d<%s, %u, %u%s>", int(sizeof(typename MAP::key) * 8), valueTypeName<T>(), unsigned(MAP::kPageSize),
+             unsigned(MAP::kMinFreeIndices), layout);
+    return std::string(buf);
+}
+
+std::vector<size_t> makeShuffledIndices(size_t num, uint64_t seed)
+{
+    std::vector<size_t> res(num);
+    for (size_t i = 0; i < num; i++)
+    {
+        res[i] = i;
+    }
+    std::mt19937_64 rng(seed);
+    std::shuffle(res.begin(), res.end(), rng);
+    return res;
+}
+
+template <typename MAP, typename T> void benchSlotMap(Reporter& reporter)
+{
+    const std::string name = slotMapName<MAP, T>();
+    const size_t num = reporter.opts.numElements;
+    using key = typename MAP::key;
+
+    std::vector<size_t> order = makeShuffledIndices(num, 0x5107ab);
+    std::vector<key> keys(num);
+
+    auto fill = [&](MAP& m) {
+        for (size_t i = 0; i < num; i++)
+        {
+            keys[i] = m.emplace(T(static_cast<int>(i)));
+        }
+    };
+
+    if (reporter.isEnabled(name, "emplace"))
+    {
+        resetPeakRss();
+        MAP m;
+        measure(reporter, name, "emplace", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                keys[i] = m.emplace(T(static_cast<int>(i)));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "get (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "get (random)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                const T* v = m.get(keys[order[i]]);
+                sum += v ? toU64(*v) : 0;
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "has_key (50% stale)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        for (size_t i = 0; i < num; i += 2)
+        {
+            m.erase(keys[i]);
+        }
+        measure(reporter, name, "has_key (50% stale)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                sum += m.has_key(keys[order[i]]) ? 1 : 0;
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "erase (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "erase (random)", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                m.erase(keys[order[i]]);
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "pop (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "pop (random)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                std::optional<T> v = m.pop(keys[order[i]]);
+                sum += v.has_value() ? toU64(*v) : 0;
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "churn (erase+emplace)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "churn (erase+emplace)", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                size_t k = order[i];
+                m.erase(keys[k]);
+                keys[k] = m.emplace(T(static_cast<int>(k)));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "clear"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measureOnce(reporter, name, "clear", num, [&]() { m.clear(); });
+    }
+
+    if (reporter.isEnabled(name, "copyFrom"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measureOnce(reporter, name, "copyFrom", num, [&]() {
+            MAP copy(m);
+            gSink += copy.size();
+        });
+    }
+
+    // iterate over a map where every other element has been erased (half of the slots are tombstones)
+    if (reporter.isEnabled(name, "iterate values") || reporter.isEnabled(name, "iterate items"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        for (size_t i = 0; i < num; i += 2)
+        {
+            m.erase(keys[order[i]]);
+        }
+
+        if (reporter.isEnabled(name, "iterate values"))
+        {
+            measureOnce(reporter, name, "iterate values", m.size(), [&]() {
+                uint64_t sum = 0;
+                for (const T& v : m)
+                {
+                    sum += toU64(v);
+                }
+                gSink += sum;
+            });
+        }
+
+        if (reporter.isEnabled(name, "iterate items"))
+        {
+            measureOnce(reporter, name, "iterate items", m.size(), [&]() {
+                uint64_t sum = 0;
+                for (const auto& [k, v] : m.items())
+                {
+                    sum += toU64(v.get()) + uint64_t(k);
+                }
+                gSink += sum;
+            });
+        }
+    }
+}
+
+template <typename T> void benchUnorderedMap(Reporter& reporter)
+{
+    const std::string name = std::string("std::unordered_map<u64, ") + valueTypeName<T>() + ">";
+    const size_t num = reporter.opts.numElements;
+    using MAP = std::unordered_map<uint64_t, T>;
+
+    std::vector<size_t> order = makeShuffledIndices(num, 0x5107ab);
+
+    auto fill = [&](MAP& m) {
+        for (size_t i = 0; i < num; i++)
+        {
+            m.emplace(uint64_t(i), T(static_cast<int>(i)));
+        }
+    };
+
+    if (reporter.isEnabled(name, "emplace"))
+    {
+        resetPeakRss();
+        MAP m;
+        measure(reporter, name, "emplace", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                m.emplace(uint64_t(i), T(static_cast<int>(i)));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "get (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "get (random)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                auto it = m.find(uint64_t(order[i]));
+                sum += (it != m.end()) ? toU64(it->second) : 0;
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "has_key (50% stale)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        for (size_t i = 0; i < num; i += 2)
+        {
+            m.erase(uint64_t(i));
+        }
+        measure(reporter, name, "has_key (50% stale)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                sum += m.count(uint64_t(order[i]));
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "erase (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "erase (random)", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                m.erase(uint64_t(order[i]));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "pop (random)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measure(reporter, name, "pop (random)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                auto it = m.find(uint64_t(order[i]));
+                if (it != m.end())
+                {
+                    T v(std::move(it->second));
+                    m.erase(it);
+                    sum += toU64(v);
+                }
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "churn (erase+emplace)"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        uint64_t nextKey = num;
+        measure(reporter, name, "churn (erase+emplace)", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                m.erase(uint64_t(order[i]));
+                m.emplace(nextKey++, T(static_cast<int>(i)));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "clear"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measureOnce(reporter, name, "clear", num, [&]() { m.clear(); });
+    }
+
+    if (reporter.isEnabled(name, "copyFrom"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        measureOnce(reporter, name, "copyFrom", num, [&]() {
+            MAP copy(m);
+            gSink += copy.size();
+        });
+    }
+
+    if (reporter.isEnabled(name, "iterate values") || reporter.isEnabled(name, "iterate items"))
+    {
+        resetPeakRss();
+        MAP m;
+        fill(m);
+        for (size_t i = 0; i < num; i += 2)
+        {
+            m.erase(uint64_t(order[i]));
+        }
+
+        if (reporter.isEnabled(name, "iterate values"))
+        {
+            measureOnce(reporter, name, "iterate values", m.size(), [&]() {
+                uint64_t sum = 0;
+                for (const auto& kv : m)
+                {
+                    sum += toU64(kv.second);
+                }
+                gSink += sum;
+            });
+        }
+
+        if (reporter.isEnabled(name, "iterate items"))
+        {
+            measureOnce(reporter, name, "iterate items", m.size(), [&]() {
+                uint64_t sum = 0;
+                for (const auto& [k, v] : m)
+                {
+                    sum += toU64(v) + k;
+                }
+                gSink += sum;
+            });
+        }
+    }
+}
+
+// std::vector is the lower bound for emplace/get/iterate (no erase support, index is the key)
+template <typename T> void benchVector(Reporter& reporter)
+{
+    const std::string name = std::string("std::vector<") + valueTypeName<T>() + ">";
+    const size_t num = reporter.opts.numElements;
+    using VEC = std::vector<T>;
+
+    std::vector<size_t> order = makeShuffledIndices(num, 0x5107ab);
+
+    auto fill = [&](VEC& v) {
+        for (size_t i = 0; i < num; i++)
+        {
+            v.emplace_back(static_cast<int>(i));
+        }
+    };
+
+    if (reporter.isEnabled(name, "emplace"))
+    {
+        resetPeakRss();
+        VEC v;
+        measure(reporter, name, "emplace", num, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                v.emplace_back(static_cast<int>(i));
+            }
+        });
+    }
+
+    if (reporter.isEnabled(name, "get (random)"))
+    {
+        resetPeakRss();
+        VEC v;
+        fill(v);
+        measure(reporter, name, "get (random)", num, [&](size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                size_t index = order[i];
+                sum += (index < v.size()) ? toU64(v[index]) : 0;
+            }
+            gSink += sum;
+        });
+    }
+
+    if (reporter.isEnabled(name, "clear"))
+    {
+        resetPeakRss();
+        VEC v;
+        fill(v);
+        measureOnce(reporter, name, "clear", num, [&]() { v.clear(); });
+    }
+
+    if (reporter.isEnabled(name, "copyFrom"))
+    {
+        resetPeakRss();
+        VEC v;
+        fill(v);
+        measureOnce(reporter, name, "copyFrom", num, [&]() {
+            VEC copy(v);
+            gSink += copy.size();
+        });
+    }
+
+    if (reporter.isEnabled(name, "iterate values"))
+    {
+        resetPeakRss();
+        VEC v;
+        fill(v);
+        measureOnce(reporter, name, "iterate values", num, [&]() {
+            uint64_t sum = 0;
+            for (const T& val : v)
+            {
+                sum += toU64(val);
+            }
+            gSink += sum;
+        });
+    }
+}
+
+bool parseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--n=", 4) == 0)
+        {
+            opts.numElements = size_t(strtoull(arg + 4, nullptr, 10));
+        }
+        else if (strncmp(arg, "--filter=", 9) == 0)
+        {
+            opts.filter = arg + 9;
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            opts.csv = true;
+        }
+        else if (strcmp(arg, "--perf") == 0)
+        {
+            opts.perf = true;
+        }
+        else
+        {
+            printf("Usage: %s [--n=<number of elements>] [--filter=<substring>] [--csv] [--perf]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        return 1;
+    }
+
+    if (opts.numElements > dod::slot_map_key32<int>::kMaxIndex)
+    {
+        printf("--n must not exceed %u (slot_map_key32 index limit)\n", unsigned(dod::slot_map_key32<int>::kMaxIndex));
+        return 1;
+    }
+
+    Reporter reporter(opts);
+    reporter.printHeader();
+
+    // key width
+    benchSlotMap<dod::slot_map32<int>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int>, int>(reporter);
+
+    // PAGESIZE sweep
+    benchSlotMap<dod::slot_map64<int, 256>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int, 65536>, int>(reporter);
+
+    // MINFREEINDICES sweep
+    benchSlotMap<dod::slot_map64<int, 4096, 0>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int, 4096, 1024>, int>(reporter);
+
+    // page layout (meta next to the value)
+    benchSlotMap<dod::slot_map32<int, 4096, 64, dod::slot_map_layout_interleaved>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int, 4096, 64, dod::slot_map_layout_interleaved>, int>(reporter);
+    benchSlotMap<dod::slot_map32<int, 4096, 64, dod::slot_map_layout_dense_meta>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int, 4096, 64, dod::slot_map_layout_dense_meta>, int>(reporter);
+    benchSlotMap<dod::slot_map32<int, 4096, 64, dod::slot_map_layout_contiguous>, int>(reporter);
+    benchSlotMap<dod::slot_map64<int, 4096, 64, dod::slot_map_layout_contiguous>, int>(reporter);
+
+    // larger values
+    benchSlotMap<dod::slot_map32<Payload64>, Payload64>(reporter);
+    benchSlotMap<dod::slot_map64<Payload64>, Payload64>(reporter);
+    benchSlotMap<dod::slot_map64<Payload64, 256>, Payload64>(reporter);
+
+    // baselines
+    benchUnorderedMap<int>(reporter);
+    benchUnorderedMap<Payload64>(reporter);
+    benchVector<int>(reporter);
+    benchVector<Payload64>(reporter);
+
+    return 0;
+}
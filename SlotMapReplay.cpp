@@ -0,0 +1,152 @@
+#include "SlotMapReplay.h"
+#include <cstring>
+
+/*
+  Replays a recorded (or synthetic) workload against several slot_map configurations.
+
+  Usage:
+    SlotMapReplay <trace file> [--csv]
+    SlotMapReplay --synthetic=<steady|bursty> [--ops=<N>] [--live=<N>] [--save=<trace file>] [--csv]
+
+  Traces are recorded with SLOT_MAP_TRACE + slot_map::set_trace_recorder() (see slot_map_trace.h).
+  Note: build in Release, Debug numbers are meaningless.
+*/
+
+namespace
+{
+
+struct Options
+{
+    const char* tracePath = nullptr;
+    const char* synthetic = nullptr;
+    const char* savePath = nullptr;
+    size_t numOps = 4000000;
+    uint32_t liveSetSize = 100000;
+    bool csv = false;
+};
+
+void printHeader(const Options& opts)
+{
+    if (opts.csv)
+    {
+        printf("workload,config,completed,ops,ns_per_op,peak_mb,deactivated_slots,index_space_used\n");
+    }
+    else
+    {
+        printf("%-30s %-32s %10s %10s %10s %12s %14s\n", "workload", "config", "ops", "ns/op", "peak (MB)", "deactivated", "index space");
+    }
+}
+
+void printResult(const Options& opts, const replay::Workload& workload, const std::string& config, const replay::Result& r)
+{
+    double peakMb = double(r.peakBytes) / (1024.0 * 1024.0);
+    if (opts.csv)
+    {
+        printf("%s,%s,%d,%llu,%.3f,%.3f,%llu,%llu\n", workload.name.c_str(), config.c_str(), r.completed ? 1 : 0,
+               (unsigned long long)r.numOpsReplayed, r.nsPerOp(), peakMb, (unsigned long long)r.numDeactivatedSlots,
+               (unsigned long long)r.indexSpaceUsed);
+    }
+    else
+    {
+        printf("%-30s %-32s %10llu %10.2f %10.2f %12llu %14llu%s\n", workload.name.c_str(), config.c_str(),
+               (unsigned long long)r.numOpsReplayed, r.nsPerOp(), peakMb, (unsigned long long)r.numDeactivatedSlots,
+               (unsigned long long)r.indexSpaceUsed, r.completed ? "" : "  (index space exhausted)");
+    }
+    fflush(stdout);
+}
+
+template <typename MAP, typename VALUE> void run(const Options& opts, const replay::Workload& workload)
+{
+    replay::Result r = replay::replayWorkload<MAP, VALUE>(workload);
+    printResult(opts, workload, replay::configName<MAP>(sizeof(VALUE)), r);
+}
+
+template <typename VALUE> void runAllConfigs(const Options& opts, const replay::Workload& workload)
+{
+    run<dod::slot_map32<VALUE, 1024, 64>, VALUE>(opts, workload);
+    run<dod::slot_map32<VALUE, 4096, 64>, VALUE>(opts, workload);
+    run<dod::slot_map32<VALUE, 4096, 1024>, VALUE>(opts, workload);
+    run<dod::slot_map64<VALUE, 1024, 64>, VALUE>(opts, workload);
+    run<dod::slot_map64<VALUE, 4096, 64>, VALUE>(opts, workload);
+    run<dod::slot_map64<VALUE, 4096, 1024>, VALUE>(opts, workload);
+    run<dod::slot_map64<VALUE, 16384, 64>, VALUE>(opts, workload);
+    run<dod::slot_map64<VALUE, 16384, 1024>, VALUE>(opts, workload);
+}
+
+bool parseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--synthetic=", 12) == 0)
+        {
+            opts.synthetic = arg + 12;
+        }
+        else if (strncmp(arg, "--ops=", 6) == 0)
+        {
+            opts.numOps = size_t(strtoull(arg + 6, nullptr, 10));
+        }
+        else if (strncmp(arg, "--live=", 7) == 0)
+        {
+            opts.liveSetSize = uint32_t(strtoul(arg + 7, nullptr, 10));
+        }
+        else if (strncmp(arg, "--save=", 7) == 0)
+        {
+            opts.savePath = arg + 7;
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            opts.csv = true;
+        }
+        else if (arg[0] != '-' && opts.tracePath == nullptr)
+        {
+            opts.tracePath = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return (opts.tracePath != nullptr) != (opts.synthetic != nullptr) && opts.liveSetSize > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        printf("Usage:\n");
+        printf("  %s <trace file> [--csv]\n", argv[0]);
+        printf("  %s --synthetic=<steady|bursty> [--ops=<N>] [--live=<N>] [--save=<trace file>] [--csv]\n", argv[0]);
+        return 1;
+    }
+
+    replay::Workload workload;
+    if (opts.tracePath)
+    {
+        if (!replay::loadWorkload(opts.tracePath, workload))
+        {
+            printf("Can't load trace '%s'\n", opts.tracePath);
+            return 1;
+        }
+    }
+    else
+    {
+        workload = replay::makeSyntheticWorkload(opts.synthetic, opts.numOps, opts.liveSetSize, 0x5107ab);
+    }
+
+    if (opts.savePath && !replay::saveWorkload(opts.savePath, workload))
+    {
+        printf("Can't save trace '%s'\n", opts.savePath);
+        return 1;
+    }
+
+    printHeader(opts);
+    replay::dispatchPayload(workload.valueSize, [&](auto* payload) {
+        using VALUE = typename std::remove_pointer<decltype(payload)>::type;
+        runAllConfigs<VALUE>(opts, workload);
+    });
+    return 0;
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <slot_map.h>
+#include <slot_map_trace.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+  Workload replay engine (shared by SlotMapReplay and SlotMapTune)
+
+  A workload is a trace (see slot_map_trace.h) where every recorded key is converted into a dense handle (an ordinal of the emplace that
+  returned that key), so the replay loop does not pay for key translation and the same workload can be replayed against any slot_map
+  configuration (key width, PAGESIZE, MINFREEINDICES, value size).
+*/
+
+namespace replay
+{
+
+static const uint32_t kInvalidHandle = 0xffffffffu;
+
+struct Op
+{
+    dod::slot_map_trace_op op;
+    uint32_t handle;
+};
+
+struct Workload
+{
+    std::string name;
+    uint32_t keySize = 8;
+    uint32_t valueSize = 4;
+    uint32_t numHandles = 0;
+    std::vector<Op> ops;
+};
+
+struct Result
+{
+    // false if the replay has been stopped because the key index space is about to be exhausted
+    bool completed = true;
+    uint64_t numOpsReplayed = 0;
+    uint64_t numEmplaces = 0;
+    double totalNs = 0.0;
+    // peak memory footprint (sampled)
+    size_t peakBytes = 0;
+    // slots deactivated because of version overflow (including the slots of released pages)
+    uint64_t numDeactivatedSlots = 0;
+    // number of slot indices used so far (pages * PAGESIZE)
+    uint64_t indexSpaceUsed = 0;
+    uint64_t maxIndex = 0;
+    uint32_t numItemsAtEnd = 0;
+
+    double nsPerOp() const { return numOpsReplayed ? totalNs / double(numOpsReplayed) : 0.0; }
+};
+
+/*
+  Converts trace records into a workload
+*/
+inline Workload makeWorkload(const char* name, const dod::slot_map_trace_header& header, const std::vector<dod::slot_map_trace_record>& records)
+{
+    // tag bits are not a part of the slot identity (see slot_map_key64/slot_map_key32)
+    const uint64_t tagMask = (header.keySize == 8) ? uint64_t(dod::slot_map_key64<void>::kHandleTagMask)
+                                                   : uint64_t(dod::slot_map_key32<void>::kHandleTagMask);
+
+    Workload res;
+    res.name = name;
+    res.keySize = header.keySize;
+    res.valueSize = header.valueSize;
+    res.ops.reserve(records.size());
+
+    std::unordered_map<uint64_t, uint32_t> keyToHandle;
+    for (const dod::slot_map_trace_record& record : records)
+    {
+        uint64_t rawKey = record.key & ~tagMask;
+        Op op;
+        op.op = record.op;
+        op.handle = kInvalidHandle;
+        if (record.op == dod::slot_map_trace_op::Emplace)
+        {
+            op.handle = res.numHandles++;
+            // note: the same raw key could be returned again after reset(), the latest emplace wins
+            keyToHandle[rawKey] = op.handle;
+        }
+        else
+        {
+            auto it = keyToHandle.find(rawKey);
+            if (it != keyToHandle.end())
+            {
+                op.handle = it->second;
+            }
+        }
+        res.ops.push_back(op);
+    }
+    return res;
+}
+
+inline bool loadWorkload(const char* path, Workload& workload)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t buf[64 * 1024];
+    size_t numRead = 0;
+    while ((numRead = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        bytes.insert(bytes.end(), buf, buf + numRead);
+    }
+    fclose(f);
+
+    dod::slot_map_trace_header header;
+    std::vector<dod::slot_map_trace_record> records;
+    if (!dod::slot_map_trace_parse(bytes.data(), bytes.size(), header, records))
+    {
+        return false;
+    }
+    workload = makeWorkload(path, header, records);
+    return true;
+}
+
+/*
+  Synthetic workloads
+
+  steady - a fixed-size live set, every step erases a random live key and emplaces a new one, plus a few lookups (some of them stale)
+  bursty - waves of spawns followed by despawns of most of the live set (spawn/despawn cycles), lookups and iteration in between
+*/
+inline Workload makeSyntheticWorkload(const std::string& kind, size_t numOps, uint32_t liveSetSize, uint64_t seed)
+{
+    Workload res;
+    res.name = "synthetic:" + kind;
+    res.keySize = 8;
+    res.valueSize = 16;
+    res.ops.reserve(numOps);
+
+    std::mt19937_64 rng(seed);
+    std::vector<uint32_t> live;
+    std::vector<uint32_t> dead;
+    live.reserve(liveSetSize * 2);
+
+    auto emplace = [&]() {
+        uint32_t h = res.numHandles++;
+        res.ops.push_back(Op{dod::slot_map_trace_op::Emplace, h});
+        live.push_back(h);
+    };
+    auto eraseRandom = [&]() {
+        size_t i = size_t(rng() % live.size());
+        uint32_t h = live[i];
+        live[i] = live.back();
+        live.pop_back();
+        res.ops.push_back(Op{dod::slot_map_trace_op::Erase, h});
+        dead.push_back(h);
+    };
+    auto getRandom = [&]() {
+        // 10% of lookups use stale keys
+        bool stale = !dead.empty() && (rng() % 10) == 0;
+        if (!stale && live.empty())
+        {
+            return;
+        }
+        uint32_t h = stale ? dead[size_t(rng() % dead.size())] : live[size_t(rng() % live.size())];
+        res.ops.push_back(Op{dod::slot_map_trace_op::Get, h});
+    };
+
+    if (kind == "bursty")
+    {
+        while (res.ops.size() < numOps)
+        {
+            while (live.size() < liveSetSize && res.ops.size() < numOps)
+            {
+                emplace();
+                getRandom();
+            }
+            res.ops.push_back(Op{dod::slot_map_trace_op::IterateValues, kInvalidHandle});
+            size_t keep = liveSetSize / 8;
+            while (live.size() > keep && res.ops.size() < numOps)
+            {
+                eraseRandom();
+                getRandom();
+            }
+        }
+    }
+    else
+    {
+        while (live.size() < liveSetSize && res.ops.size() < numOps)
+        {
+            emplace();
+        }
+        while (res.ops.size() < numOps)
+        {
+            eraseRandom();
+            emplace();
+            getRandom();
+            getRandom();
+            if ((res.ops.size() % (size_t(liveSetSize) * 4)) < 4)
+            {
+                res.ops.push_back(Op{dod::slot_map_trace_op::IterateItems, kInvalidHandle});
+            }
+        }
+    }
+    res.ops.resize(std::min(res.ops.size(), numOps));
+    return res;
+}
+
+/*
+  Writes a workload as a trace file (so synthetic workloads can be replayed by other tools)
+*/
+inline bool saveWorkload(const char* path, const Workload& workload)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = false;
+    {
+        dod::slot_map_trace_recorder recorder(f);
+        recorder.begin(static_cast<uint8_t>(workload.keySize), workload.valueSize);
+        for (const Op& op : workload.ops)
+        {
+            // handles are unique, so they can be used as raw keys (+1 to never produce the invalid key)
+            uint64_t rawKey = (op.handle == kInvalidHandle) ? 0 : uint64_t(op.handle) + 1;
+            recorder.record(op.op, rawKey);
+        }
+        ok = recorder.flush();
+    }
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+template <size_t SIZE> struct Payload
+{
+    static_assert(SIZE >= sizeof(uint32_t), "Payload is too small");
+    uint32_t data[SIZE / sizeof(uint32_t)];
+
+    explicit Payload(uint32_t v) noexcept
+    {
+        data[0] = v;
+        for (size_t i = 1; i < SIZE / sizeof(uint32_t); i++)
+        {
+            data[i] = 0;
+        }
+    }
+};
+
+// Calls `func(Payload<N>*)` with the smallest payload that fits the recorded value size
+template <typename FUNC> void dispatchPayload(uint32_t valueSize, FUNC&& func)
+{
+    if (valueSize <= 4)
+    {
+        func(static_cast<Payload<4>*>(nullptr));
+    }
+    else if (valueSize <= 16)
+    {
+        func(static_cast<Payload<16>*>(nullptr));
+    }
+    else if (valueSize <= 64)
+    {
+        func(static_cast<Payload<64>*>(nullptr));
+    }
+    else
+    {
+        func(static_cast<Payload<256>*>(nullptr));
+    }
+}
+
+template <typename MAP> std::string configName(size_t valueSize)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "slot_map%d<P%u, %u, %u>", int(sizeof(typename MAP::key) * 8), unsigned(valueSize), unsigned(MAP::kPageSize),
+             unsigned(MAP::kMinFreeIndices));
+    return std::string(buf);
+}
+
+static volatile uint64_t gReplaySink = 0;
+
+/*
+  Replays the workload against the given slot map type
+*/
+template <typename MAP, typename VALUE> Result replayWorkload(const Workload& workload)
+{
+    using clock = std::chrono::steady_clock;
+    using key = typename MAP::key;
+    static const size_t kChunkSize = 4096;
+
+    Result res;
+    res.maxIndex = uint64_t(key::kMaxIndex);
+
+    std::vector<key> handles(workload.numHandles, key::invalid());
+    MAP m;
+    uint64_t sink = 0;
+
+    auto keyOf = [&](uint32_t handle) { return (handle == kInvalidHandle) ? key::invalid() : handles[handle]; };
+
+    for (size_t begin = 0; begin < workload.ops.size(); begin += kChunkSize)
+    {
+        size_t end = std::min(begin + kChunkSize, workload.ops.size());
+
+        // stop before the key index space is exhausted (one chunk could add up to kChunkSize new slots)
+        auto stats = m.stats();
+        uint64_t indexSpaceUpperBound = (uint64_t(stats.numPagesTotal) + 1) * MAP::kPageSize + kChunkSize;
+        if (indexSpaceUpperBound > uint64_t(key::kMaxIndex) + 1)
+        {
+            res.completed = false;
+            break;
+        }
+
+        auto t0 = clock::now();
+        for (size_t i = begin; i < end; i++)
+        {
+            const Op& op = workload.ops[i];
+            switch (op.op)
+            {
+            case dod::slot_map_trace_op::Emplace:
+                handles[op.handle] = m.emplace(VALUE(op.handle));
+                break;
+            case dod::slot_map_trace_op::Erase:
+                m.erase(keyOf(op.handle));
+                break;
+            case dod::slot_map_trace_op::Pop:
+                sink += m.pop(keyOf(op.handle)).has_value() ? 1 : 0;
+                break;
+            case dod::slot_map_trace_op::Get:
+            {
+                const VALUE* v = m.get(keyOf(op.handle));
+                sink += v ? v->data[0] : 0;
+                break;
+            }
+            case dod::slot_map_trace_op::HasKey:
+                sink += m.has_key(keyOf(op.handle)) ? 1 : 0;
+                break;
+            case dod::slot_map_trace_op::Clear:
+                m.clear();
+                break;
+            case dod::slot_map_trace_op::Reset:
+                m.reset();
+                break;
+            case dod::slot_map_trace_op::IterateValues:
+                for (const VALUE& v : m)
+                {
+                    sink += v.data[0];
+                }
+                break;
+            case dod::slot_map_trace_op::IterateItems:
+                for (const auto& kv : m.items())
+                {
+                    sink += kv.second.get().data[0] + uint64_t(kv.first);
+                }
+                break;
+            }
+        }
+        auto t1 = clock::now();
+        res.totalNs += double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        res.numOpsReplayed += uint64_t(end - begin);
+        res.peakBytes = std::max(res.peakBytes, m.memory_stats().totalBytes);
+    }
+
+    for (size_t i = 0; i < size_t(res.numOpsReplayed); i++)
+    {
+        res.numEmplaces += (workload.ops[i].op == dod::slot_map_trace_op::Emplace) ? 1 : 0;
+    }
+
+    auto stats = m.stats();
+    res.numDeactivatedSlots = uint64_t(stats.numInactiveItems) + uint64_t(stats.numInactivePages) * MAP::kPageSize;
+    res.indexSpaceUsed = uint64_t(stats.numPagesTotal) * MAP::kPageSize;
+    res.numItemsAtEnd = stats.numAliveItems;
+    gReplaySink += sink;
+    return res;
+}
+
+} // namespace replay
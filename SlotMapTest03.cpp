@@ -110,4 +110,73 @@ TEST(SlotMapTest, BasicIterators3)
     }
     EXPECT_EQ(sum, 10);
     EXPECT_EQ(numSteps, 4);
-}
\ No newline at end of file
+}
+
+TEST(SlotMapTest, SparseIterators)
+{
+    using SlotMap = dod::slot_map64<std::string, 128, 0>;
+    SlotMap slotMap;
+
+    std::vector<SlotMap::key> keys;
+    for (int i = 0; i < 1000; i++)
+    {
+        keys.emplace_back(slotMap.emplace(std::to_string(i)));
+    }
+
+    // erase every third element, the whole second page and a few elements around the bitmap word boundaries
+    std::unordered_map<std::string, SlotMap::key> expected;
+    for (int i = 0; i < 1000; i++)
+    {
+        bool remove = (i % 3) == 0 || (i >= 128 && i < 256) || i == 62 || i == 64 || i == 127 || i == 999;
+        if (remove)
+        {
+            slotMap.erase(keys[i]);
+        }
+        else
+        {
+            expected[std::to_string(i)] = keys[i];
+        }
+    }
+    ASSERT_EQ(size_t(slotMap.size()), expected.size());
+
+    auto validate = [&expected](const SlotMap& m) {
+        size_t numValues = 0;
+        for (const std::string& value : m)
+        {
+            ASSERT_NE(expected.find(value), expected.end());
+            numValues++;
+        }
+        EXPECT_EQ(numValues, expected.size());
+
+        size_t numItems = 0;
+        for (const auto& [key, value] : m.items())
+        {
+            auto it = expected.find(value);
+            ASSERT_NE(it, expected.end());
+            ASSERT_EQ(it->second, key);
+            numItems++;
+        }
+        EXPECT_EQ(numItems, expected.size());
+        m.debug_stats();
+    };
+
+    validate(slotMap);
+
+    // copy only has to copy live values (tombstones hold destroyed values)
+    SlotMap slotMapCopy(slotMap);
+    validate(slotMapCopy);
+
+    slotMapCopy.clear();
+    EXPECT_EQ(slotMapCopy.size(), uint32_t(0));
+    EXPECT_EQ(slotMapCopy.begin(), slotMapCopy.end());
+    EXPECT_EQ(slotMapCopy.items().begin(), slotMapCopy.items().end());
+    slotMapCopy.debug_stats();
+
+    // original is not affected
+    validate(slotMap);
+
+    auto k = slotMapCopy.emplace("new");
+    ASSERT_NE(slotMapCopy.begin(), slotMapCopy.end());
+    EXPECT_EQ(*slotMapCopy.begin(), "new");
+    EXPECT_EQ(slotMapCopy.items().begin()->first, k);
+}
@@ -142,6 +142,65 @@ TEST(SlotMapTest, InvalidAndMalformedKeys)
     slotMap.erase(zeroKey);
 }
 
+TEST(SlotMapTest, LookupSentinels)
+{
+    using SlotMap = dod::slot_map64<int, 32, 0>;
+    using Key = SlotMap::key;
+    SlotMap slotMap;
+
+    // empty slot map
+    EXPECT_EQ(slotMap.get(Key::make(Key::kMinVersion, 0)), nullptr);
+    EXPECT_FALSE(slotMap.has_key(Key::make(Key::kMinVersion, 0)));
+    EXPECT_FALSE(slotMap.has_key(Key::invalid()));
+
+    // never used slots of the last page and indices beyond the last page
+    Key k0 = slotMap.emplace(1);
+    EXPECT_EQ(*slotMap.get(k0), 1);
+    for (uint32_t index = 1; index < 100; index++)
+    {
+        EXPECT_EQ(slotMap.get(Key::make(Key::kMinVersion, index)), nullptr);
+        EXPECT_FALSE(slotMap.has_key(Key::make(Key::kMinVersion, index)));
+    }
+    EXPECT_EQ(slotMap.get(Key::make(Key::kMinVersion, Key::kMaxIndex)), nullptr);
+
+    // released page (every slot of the first page reached the max version)
+    for (uint32_t i = 1; i < SlotMap::kPageSize; i++)
+    {
+        slotMap.emplace(int(i));
+    }
+    for (size_t j = 0; j < static_cast<size_t>(Key::kMaxVersion) + 1; j++)
+    {
+        slotMap.clear();
+        for (uint32_t i = 0; i < SlotMap::kPageSize; i++)
+        {
+            slotMap.emplace(int(i));
+        }
+    }
+    auto stats = slotMap.stats();
+    EXPECT_EQ(stats.numInactivePages, 1u);
+    for (uint32_t index = 0; index < SlotMap::kPageSize; index++)
+    {
+        for (Key::version_t version : {Key::kMinVersion, Key::kMaxVersion})
+        {
+            EXPECT_EQ(slotMap.get(Key::make(version, index)), nullptr);
+            EXPECT_FALSE(slotMap.has_key(Key::make(version, index)));
+        }
+    }
+    for (const auto& [key, value] : slotMap.items())
+    {
+        ASSERT_NE(slotMap.get(key), nullptr);
+        EXPECT_EQ(*slotMap.get(key), value);
+    }
+
+    // moved-from slot map
+    Key alive = slotMap.items().begin()->first;
+    SlotMap moved(std::move(slotMap));
+    EXPECT_EQ(moved.size(), SlotMap::kPageSize);
+    EXPECT_EQ(slotMap.get(alive), nullptr);
+    EXPECT_FALSE(slotMap.has_key(alive));
+    EXPECT_NE(moved.get(alive), nullptr);
+}
+
 TEST(SlotMapTest, WorkingWithRemovedPages)
 {
     dod::slot_map64<int, 32, 0> slotMap;
@@ -190,3 +249,203 @@ TEST(SlotMapTest, WorkingWithRemovedPages)
     printf("Items: total: %d, alive: %d, tombstone: %d, inactive: %d\n", int(stats.numItemsTotal), int(stats.numAliveItems),
            int(stats.numTombstoneItems), int(stats.numInactiveItems));
 }
+
+template <typename STATS> static void expectStatsEqual(const STATS& a, const STATS& b)
+{
+    EXPECT_EQ(a.numPagesTotal, b.numPagesTotal);
+    EXPECT_EQ(a.numInactivePages, b.numInactivePages);
+    EXPECT_EQ(a.numActivePages, b.numActivePages);
+    EXPECT_EQ(a.numItemsTotal, b.numItemsTotal);
+    EXPECT_EQ(a.numAliveItems, b.numAliveItems);
+    EXPECT_EQ(a.numTombstoneItems, b.numTombstoneItems);
+    EXPECT_EQ(a.numInactiveItems, b.numInactiveItems);
+}
+
+TEST(SlotMapTest, IncrementalStats)
+{
+    dod::slot_map64<int, 32, 0> slotMap;
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+
+    // reuse the same slot until it is deactivated because of version overflow
+    for (size_t j = 0; j < static_cast<size_t>(decltype(slotMap)::key::kMaxVersion) + 10; j++)
+    {
+        auto id = slotMap.emplace(13);
+        slotMap.erase(id);
+    }
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+    EXPECT_EQ(slotMap.stats().numInactiveItems, 1u);
+
+    std::vector<dod::slot_map64<int, 32, 0>::key> keys;
+    for (int i = 0; i < 100; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+    EXPECT_EQ(slotMap.stats().numAliveItems, 100u);
+
+    for (size_t i = 0; i < keys.size(); i += 3)
+    {
+        slotMap.erase(keys[i]);
+    }
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+    EXPECT_EQ(slotMap.stats().numAliveItems, 66u);
+
+    decltype(slotMap) copy(slotMap);
+    expectStatsEqual(copy.stats(), slotMap.stats());
+    expectStatsEqual(copy.stats(), copy.debug_stats());
+
+    // clear() deactivates whole pages when the version overflows
+    for (size_t j = 0; j < static_cast<size_t>(decltype(slotMap)::key::kMaxVersion) + 10; j++)
+    {
+        slotMap.emplace(1);
+        slotMap.clear();
+    }
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+    EXPECT_EQ(slotMap.stats().numAliveItems, 0u);
+
+    decltype(slotMap) moved(std::move(copy));
+    expectStatsEqual(moved.stats(), moved.debug_stats());
+    expectStatsEqual(copy.stats(), copy.debug_stats());
+
+    slotMap.reset();
+    expectStatsEqual(slotMap.stats(), decltype(slotMap)::Stats());
+}
+
+TEST(SlotMapTest, VersionOverflow32)
+{
+    using SlotMap = dod::slot_map32<int, 32, 0>;
+    SlotMap slotMap;
+
+    // every version of the slot must produce a unique key, and the last one must deactivate the slot
+    std::vector<SlotMap::key> keys;
+    for (size_t j = 0; j < static_cast<size_t>(SlotMap::key::kMaxVersion) + 10; j++)
+    {
+        auto id = slotMap.emplace(int(j));
+        ASSERT_NE(SlotMap::key::toVersion(id), SlotMap::key::kInvalidVersion);
+        ASSERT_NE(slotMap.get(id), nullptr);
+        for (const SlotMap::key& oldId : keys)
+        {
+            ASSERT_FALSE(oldId == id);
+        }
+        slotMap.erase(id);
+        EXPECT_FALSE(slotMap.has_key(id));
+        EXPECT_EQ(slotMap.get(id), nullptr);
+        keys.emplace_back(id);
+    }
+
+    EXPECT_EQ(slotMap.size(), 0u);
+    EXPECT_EQ(slotMap.stats().numInactiveItems, 1u);
+    expectStatsEqual(slotMap.stats(), slotMap.debug_stats());
+    for (const SlotMap::key& id : keys)
+    {
+        EXPECT_FALSE(slotMap.has_key(id));
+    }
+}
+
+TEST(SlotMapTest, MemoryStatsAndPageOccupancy)
+{
+    dod::slot_map64<uint64_t, 32, 0> slotMap;
+    auto mem0 = slotMap.memory_stats();
+    EXPECT_EQ(mem0.pageBytesReserved, size_t(0));
+    EXPECT_EQ(mem0.liveValueBytes, size_t(0));
+    EXPECT_TRUE(slotMap.debug_page_occupancy().empty());
+
+    std::vector<dod::slot_map64<uint64_t, 32, 0>::key> keys;
+    for (uint64_t i = 0; i < 80; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+
+    // erase the whole first page and a few items from the second one
+    for (size_t i = 0; i < 40; i++)
+    {
+        slotMap.erase(keys[i]);
+    }
+
+    auto mem = slotMap.memory_stats();
+    EXPECT_EQ(mem.valueBytesReserved, size_t(3 * 32 * sizeof(uint64_t)));
+    EXPECT_EQ(mem.liveValueBytes, size_t(40 * sizeof(uint64_t)));
+    EXPECT_EQ(mem.wastedValueBytes, mem.valueBytesReserved - mem.liveValueBytes);
+    EXPECT_GE(mem.pageBytesReserved, mem.valueBytesReserved + mem.metaBytes);
+    // the free list is stored in the tombstoned slots
+    EXPECT_EQ(mem.freeIndicesBytes, size_t(0));
+    EXPECT_GT(mem.pagesVectorBytes, size_t(0));
+    EXPECT_EQ(mem.totalBytes, mem.pageBytesReserved + mem.pagesVectorBytes + mem.freeIndicesBytes);
+
+    auto occupancy = slotMap.debug_page_occupancy();
+    ASSERT_EQ(occupancy.size(), size_t(3));
+    EXPECT_TRUE(occupancy[0].active);
+    EXPECT_EQ(occupancy[0].numAliveItems, 0u);
+    EXPECT_EQ(occupancy[0].numTombstoneItems, 32u);
+    EXPECT_EQ(occupancy[1].numAliveItems, 24u);
+    EXPECT_EQ(occupancy[1].numTombstoneItems, 8u);
+    EXPECT_EQ(occupancy[2].numAliveItems, 16u);
+    EXPECT_EQ(occupancy[2].numUnusedItems, 16u);
+}
+
+struct RecordedEvents
+{
+    const void* slotMap = nullptr;
+    std::vector<uint32_t> allocatedPages;
+    std::vector<uint32_t> releasedPages;
+    uint32_t numSlotsDeactivated = 0;
+};
+
+TEST(SlotMapTest, EventHooks)
+{
+    using SlotMap = dod::slot_map64<int, 32, 0>;
+
+    SlotMap::EventHooks hooks;
+    hooks.onPageAllocate = [](const SlotMap::EventInfo& info, void* userData) {
+        RecordedEvents* events = static_cast<RecordedEvents*>(userData);
+        EXPECT_EQ(info.slotMap, events->slotMap);
+        EXPECT_NE(info.typeName, nullptr);
+        EXPECT_GT(info.sizeInBytes, size_t(0));
+        events->allocatedPages.emplace_back(info.pageIndex);
+    };
+    hooks.onPageRelease = [](const SlotMap::EventInfo& info, void* userData) {
+        RecordedEvents* events = static_cast<RecordedEvents*>(userData);
+        EXPECT_EQ(info.slotMap, events->slotMap);
+        events->releasedPages.emplace_back(info.pageIndex);
+    };
+    hooks.onSlotDeactivate = [](const SlotMap::EventInfo& info, void* userData) {
+        RecordedEvents* events = static_cast<RecordedEvents*>(userData);
+        EXPECT_EQ(info.slotMap, events->slotMap);
+        EXPECT_EQ(info.pageIndex, 0u);
+        EXPECT_EQ(info.slotIndex, 0u);
+        events->numSlotsDeactivated++;
+    };
+
+    RecordedEvents events;
+    hooks.userData = &events;
+    {
+        SlotMap slotMap;
+        events.slotMap = &slotMap;
+        slotMap.set_event_hooks(&hooks);
+        EXPECT_EQ(slotMap.get_event_hooks(), &hooks);
+
+        // reuse the same slot until it is deactivated because of version overflow
+        for (size_t j = 0; j < static_cast<size_t>(SlotMap::key::kMaxVersion) + 1; j++)
+        {
+            slotMap.erase(slotMap.emplace(1));
+        }
+        EXPECT_EQ(events.numSlotsDeactivated, 1u);
+        ASSERT_EQ(events.allocatedPages.size(), size_t(1));
+
+        for (int i = 0; i < 40; i++)
+        {
+            slotMap.emplace(i);
+        }
+        ASSERT_EQ(events.allocatedPages.size(), size_t(2));
+        EXPECT_EQ(events.allocatedPages[0], 0u);
+        EXPECT_EQ(events.allocatedPages[1], 1u);
+
+        slotMap.reset();
+        ASSERT_EQ(events.releasedPages.size(), size_t(2));
+
+        slotMap.emplace(1);
+        EXPECT_EQ(events.allocatedPages.size(), size_t(3));
+    }
+    // destructor releases the remaining page
+    EXPECT_EQ(events.releasedPages.size(), size_t(3));
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <slot_map.h>
+#include <thread>
+#include <vector>
+
+// Note: these tests are only compiled if SLOT_MAP_INSTRUMENT is defined (cmake -DSLOT_MAP_INSTRUMENT=ON ..)
+#if defined(SLOT_MAP_INSTRUMENT)
+
+TEST(SlotMapTest, InstrumentCounters)
+{
+    dod::slot_map64<int, 32, 4> slotMap;
+
+    std::vector<dod::slot_map64<int, 32, 4>::key> keys;
+    for (int i = 0; i < 40; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+
+    const auto& counters = slotMap.instrument_counters();
+    EXPECT_EQ(counters.emplaceFresh, 40u);
+    EXPECT_EQ(counters.emplaceRecycled, 0u);
+    EXPECT_EQ(counters.pagesAllocated, 2u);
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        slotMap.erase(keys[i]);
+    }
+    EXPECT_EQ(counters.freeIndicesHighWaterMark, 10u);
+
+    // hit
+    EXPECT_NE(slotMap.get(keys[20]), nullptr);
+    // version mismatch
+    EXPECT_EQ(slotMap.get(keys[0]), nullptr);
+    // out of range
+    EXPECT_EQ(slotMap.get(dod::slot_map64<int, 32, 4>::key::make(1, 1000)), nullptr);
+
+    EXPECT_EQ(counters.getHits, 1u);
+    EXPECT_EQ(counters.getMissesVersionMismatch, 1u);
+    EXPECT_EQ(counters.getMissesOutOfRange, 1u);
+    EXPECT_EQ(counters.getMissesInactivePage, 0u);
+
+    auto id = slotMap.emplace(100);
+    EXPECT_EQ(counters.emplaceRecycled, 1u);
+    slotMap.erase(id);
+
+    // reuse the same slot until it is deactivated because of version overflow
+    dod::slot_map64<int, 32, 0> churnMap;
+    for (size_t j = 0; j < static_cast<size_t>(decltype(churnMap)::key::kMaxVersion) + 1; j++)
+    {
+        churnMap.erase(churnMap.emplace(1));
+    }
+    const auto& churnCounters = churnMap.instrument_counters();
+    EXPECT_EQ(churnCounters.slotsDeactivated, 1u);
+
+    std::string json = slotMap.instrument_json();
+    EXPECT_NE(json.find("\"get_hits\":1,"), std::string::npos);
+    EXPECT_NE(json.find("\"get_misses_version_mismatch\":1,"), std::string::npos);
+    EXPECT_NE(json.find("\"emplace_fresh\":40,"), std::string::npos);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+
+    slotMap.reset();
+    EXPECT_EQ(counters.pagesFreed, 2u);
+
+    slotMap.reset_instrument_counters();
+    EXPECT_EQ(counters.getHits, 0u);
+}
+
+TEST(SlotMapTest, InstrumentCountersConcurrentReaders)
+{
+    dod::slot_map64<int> slotMap;
+    auto k = slotMap.emplace(1);
+    const dod::slot_map64<int>& constMap = slotMap;
+
+    // concurrent reads of a const map are legal, so are the counters they update
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&constMap, k]() {
+            for (int i = 0; i < 10000; i++)
+            {
+                EXPECT_NE(constMap.get(k), nullptr);
+                EXPECT_TRUE(constMap.has_key(k));
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(slotMap.instrument_counters().getHits, 40000u);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <slot_map.h>
+#include <slot_map_trace.h>
+
+TEST(SlotMapTest, TraceRecorderRoundTrip)
+{
+    dod::slot_map_trace_recorder recorder;
+    recorder.begin(8, 16);
+    recorder.record(dod::slot_map_trace_op::Emplace, 0x0000000100000000ull);
+    recorder.record(dod::slot_map_trace_op::Get, 0x0000000100000000ull);
+    recorder.record(dod::slot_map_trace_op::IterateItems, 0);
+    recorder.record(dod::slot_map_trace_op::Erase, 0xfff0000100000000ull);
+
+    const std::vector<uint8_t>& data = recorder.data();
+    EXPECT_EQ(data.size(), dod::slot_map_trace_header::kSizeInBytes + 4 * 9);
+
+    dod::slot_map_trace_header header;
+    std::vector<dod::slot_map_trace_record> records;
+    ASSERT_TRUE(dod::slot_map_trace_parse(data.data(), data.size(), header, records));
+    EXPECT_EQ(header.keySize, 8u);
+    EXPECT_EQ(header.valueSize, 16u);
+    ASSERT_EQ(records.size(), size_t(4));
+    EXPECT_EQ(records[0].op, dod::slot_map_trace_op::Emplace);
+    EXPECT_EQ(records[0].key, 0x0000000100000000ull);
+    EXPECT_EQ(records[1].op, dod::slot_map_trace_op::Get);
+    EXPECT_EQ(records[2].op, dod::slot_map_trace_op::IterateItems);
+    EXPECT_EQ(records[3].op, dod::slot_map_trace_op::Erase);
+    EXPECT_EQ(records[3].key, 0xfff0000100000000ull);
+
+    // truncated and malformed traces
+    EXPECT_FALSE(dod::slot_map_trace_parse(data.data(), data.size() - 1, header, records));
+    EXPECT_FALSE(dod::slot_map_trace_parse(data.data(), 3, header, records));
+    std::vector<uint8_t> malformed = data;
+    malformed[0] = 'X';
+    EXPECT_FALSE(dod::slot_map_trace_parse(malformed.data(), malformed.size(), header, records));
+}
+
+TEST(SlotMapTest, TraceRecorderOverflow)
+{
+    // in-memory: the records that don't fit into the buffer are dropped (recording never allocates)
+    const size_t capacity = dod::slot_map_trace_header::kSizeInBytes + 10 * 5;
+    dod::slot_map_trace_recorder recorder(nullptr, capacity);
+    recorder.begin(4, 4);
+    for (int i = 0; i < 15; i++)
+    {
+        recorder.record(dod::slot_map_trace_op::Get, uint64_t(i));
+    }
+    EXPECT_EQ(recorder.data().size(), capacity);
+    EXPECT_EQ(recorder.data().capacity(), capacity);
+    EXPECT_EQ(recorder.num_dropped_records(), uint64_t(5));
+    EXPECT_FALSE(recorder.failed());
+
+    // a failed file write is reported, its records are dropped as well
+    const char* path = "trace_overflow_test.smtrace";
+    FILE* f = fopen(path, "wb");
+    ASSERT_NE(f, nullptr);
+    fclose(f);
+    f = fopen(path, "rb");
+    ASSERT_NE(f, nullptr);
+    {
+        dod::slot_map_trace_recorder fileRecorder(f, capacity);
+        fileRecorder.begin(4, 4);
+        for (int i = 0; i < 15; i++)
+        {
+            fileRecorder.record(dod::slot_map_trace_op::Get, uint64_t(i));
+        }
+        EXPECT_FALSE(fileRecorder.flush());
+        EXPECT_TRUE(fileRecorder.failed());
+        EXPECT_EQ(fileRecorder.num_dropped_records(), uint64_t(15));
+        EXPECT_TRUE(fileRecorder.data().empty());
+    }
+    fclose(f);
+    remove(path);
+}
+
+// Note: this test is only compiled if SLOT_MAP_TRACE is defined (cmake -DSLOT_MAP_TRACE=ON ..)
+#if defined(SLOT_MAP_TRACE)
+
+TEST(SlotMapTest, TraceRecording)
+{
+    dod::slot_map_trace_recorder recorder;
+
+    dod::slot_map32<int> slotMap;
+    auto unrecorded = slotMap.emplace(0);
+    slotMap.set_trace_recorder(&recorder);
+
+    auto k1 = slotMap.emplace(1);
+    auto k2 = slotMap.emplace(2);
+    slotMap.get(k1);
+    slotMap.has_key(unrecorded);
+    slotMap.erase(k2);
+    slotMap.pop(k1);
+    for (const auto& v : slotMap)
+    {
+        (void)v;
+    }
+    for (const auto& kv : slotMap.items())
+    {
+        (void)kv;
+    }
+    slotMap.clear();
+    slotMap.reset();
+
+    // copies do not inherit the recorder
+    dod::slot_map32<int> copy(slotMap);
+    copy.emplace(3);
+
+    slotMap.set_trace_recorder(nullptr);
+    slotMap.emplace(4);
+
+    const std::vector<uint8_t>& data = recorder.data();
+    dod::slot_map_trace_header header;
+    std::vector<dod::slot_map_trace_record> records;
+    ASSERT_TRUE(dod::slot_map_trace_parse(data.data(), data.size(), header, records));
+    EXPECT_EQ(header.keySize, 4u);
+    EXPECT_EQ(header.valueSize, uint32_t(sizeof(int)));
+
+    const dod::slot_map_trace_op expected[] = {
+        dod::slot_map_trace_op::Emplace,       dod::slot_map_trace_op::Emplace,      dod::slot_map_trace_op::Get,
+        dod::slot_map_trace_op::HasKey,        dod::slot_map_trace_op::Erase,        dod::slot_map_trace_op::Pop,
+        dod::slot_map_trace_op::IterateValues, dod::slot_map_trace_op::IterateItems, dod::slot_map_trace_op::Clear,
+        dod::slot_map_trace_op::Reset,
+    };
+    ASSERT_EQ(records.size(), sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        EXPECT_EQ(records[i].op, expected[i]);
+    }
+    EXPECT_EQ(records[0].key, uint64_t(k1));
+    EXPECT_EQ(records[1].key, uint64_t(k2));
+    EXPECT_EQ(records[3].key, uint64_t(unrecorded));
+}
+
+#endif
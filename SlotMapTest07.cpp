@@ -0,0 +1,373 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <slot_map.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+// runs the same random workload against the given slot map and validates it against a reference std::unordered_map
+template <typename SLOT_MAP, typename MAKE_VALUE> void runLayoutWorkload(MAKE_VALUE makeValue)
+{
+    using key = typename SLOT_MAP::key;
+    SLOT_MAP slotMap;
+    std::unordered_map<key, int> reference;
+    std::vector<key> removed;
+    std::mt19937 rng(42);
+
+    for (int step = 0; step < 20000; step++)
+    {
+        uint32_t op = rng() % 10;
+        if (op < 5 || reference.empty())
+        {
+            key k = slotMap.emplace(makeValue(step));
+            ASSERT_EQ(reference.count(k), size_t(0));
+            reference[k] = step;
+        }
+        else if (op < 8)
+        {
+            auto it = reference.begin();
+            std::advance(it, rng() % reference.size());
+            slotMap.erase(it->first);
+            removed.emplace_back(it->first);
+            reference.erase(it);
+        }
+        else
+        {
+            slotMap.clear();
+            for (const auto& kv : reference)
+            {
+                removed.emplace_back(kv.first);
+            }
+            reference.clear();
+        }
+    }
+
+    ASSERT_EQ(size_t(slotMap.size()), reference.size());
+    for (const auto& kv : reference)
+    {
+        const auto* v = slotMap.get(kv.first);
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(*v, makeValue(kv.second));
+        EXPECT_TRUE(slotMap.has_key(kv.first));
+    }
+    for (const key& k : removed)
+    {
+        EXPECT_EQ(slotMap.get(k), nullptr);
+        EXPECT_FALSE(slotMap.has_key(k));
+    }
+
+    size_t numItems = 0;
+    for (const auto& [k, v] : slotMap.items())
+    {
+        auto it = reference.find(k);
+        ASSERT_NE(it, reference.end());
+        EXPECT_EQ(v.get(), makeValue(it->second));
+        numItems++;
+    }
+    EXPECT_EQ(numItems, reference.size());
+    slotMap.debug_stats();
+
+    SLOT_MAP copy(slotMap);
+    ASSERT_EQ(copy.size(), slotMap.size());
+    for (const auto& kv : reference)
+    {
+        const auto* v = copy.get(kv.first);
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(*v, makeValue(kv.second));
+    }
+    copy.debug_stats();
+}
+
+TEST(SlotMapTest, InterleavedLayout)
+{
+    auto makeInt = [](int v) { return v; };
+    auto makeString = [](int v) { return std::string("value_") + std::to_string(v); };
+    auto makeByte = [](int v) { return uint8_t(v & 0xff); };
+
+    runLayoutWorkload<dod::slot_map64<int, 64, 16, dod::slot_map_layout_interleaved>>(makeInt);
+    runLayoutWorkload<dod::slot_map64<std::string, 64, 16, dod::slot_map_layout_interleaved>>(makeString);
+    runLayoutWorkload<dod::slot_map32<uint8_t, 64, 16, dod::slot_map_layout_interleaved>>(makeByte);
+    runLayoutWorkload<dod::slot_map32<std::string, 4096, 64, dod::slot_map_layout_interleaved>>(makeString);
+
+    // the default (split) layout must pass the same workload
+    runLayoutWorkload<dod::slot_map64<int, 64, 16>>(makeInt);
+    runLayoutWorkload<dod::slot_map32<std::string, 64, 16>>(makeString);
+}
+
+TEST(SlotMapTest, InterleavedLayoutMemory)
+{
+    dod::slot_map64<uint32_t, 256, 0, dod::slot_map_layout_interleaved> interleaved;
+    dod::slot_map64<uint32_t, 256, 0> split;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        auto k1 = interleaved.emplace(i);
+        auto k2 = split.emplace(i);
+        EXPECT_EQ(k1, k2);
+    }
+
+    auto m1 = interleaved.memory_stats();
+    auto m2 = split.memory_stats();
+    EXPECT_EQ(m1.valueBytesReserved, m2.valueBytesReserved);
+    EXPECT_EQ(m1.metaBytes, m2.metaBytes);
+    // 4 bytes meta + 4 bytes value = no padding
+    EXPECT_EQ(m1.pageBytesReserved, m2.pageBytesReserved);
+}
+
+TEST(SlotMapTest, DenseMetaLayout)
+{
+    auto makeInt = [](int v) { return v; };
+    auto makeString = [](int v) { return std::string("value_") + std::to_string(v); };
+    auto makeByte = [](int v) { return uint8_t(v & 0xff); };
+
+    runLayoutWorkload<dod::slot_map64<int, 64, 16, dod::slot_map_layout_dense_meta>>(makeInt);
+    runLayoutWorkload<dod::slot_map64<std::string, 64, 16, dod::slot_map_layout_dense_meta>>(makeString);
+    runLayoutWorkload<dod::slot_map32<uint8_t, 64, 16, dod::slot_map_layout_dense_meta>>(makeByte);
+    runLayoutWorkload<dod::slot_map32<std::string, 4096, 64, dod::slot_map_layout_dense_meta>>(makeString);
+
+    // version overflow releases pages, keys of the released pages must never match
+    dod::slot_map32<std::string, 16, 0, dod::slot_map_layout_dense_meta> slotMap;
+    std::vector<dod::slot_map32<std::string, 16, 0, dod::slot_map_layout_dense_meta>::key> oldKeys;
+    while (slotMap.stats().numInactivePages == 0)
+    {
+        auto k = slotMap.emplace(makeString(int(oldKeys.size())));
+        oldKeys.emplace_back(k);
+        slotMap.erase(k);
+    }
+    auto live = slotMap.emplace("alive");
+    for (const auto& k : oldKeys)
+    {
+        EXPECT_FALSE(slotMap.has_key(k));
+        EXPECT_EQ(slotMap.get(k), nullptr);
+    }
+    slotMap.debug_stats();
+
+    // copy / move / swap must keep the version table in sync
+    auto copy = slotMap;
+    ASSERT_NE(copy.get(live), nullptr);
+    EXPECT_EQ(*copy.get(live), "alive");
+    decltype(slotMap) moved(std::move(copy));
+    ASSERT_NE(moved.get(live), nullptr);
+    EXPECT_FALSE(copy.has_key(live));
+    decltype(slotMap) other;
+    other.swap(moved);
+    ASSERT_NE(other.get(live), nullptr);
+    EXPECT_FALSE(moved.has_key(live));
+
+    other.reset();
+    EXPECT_FALSE(other.has_key(live));
+    EXPECT_EQ(other.memory_stats().metaTableBytes, size_t(0));
+}
+
+TEST(SlotMapTest, DenseMetaLayoutMemory)
+{
+    dod::slot_map64<uint64_t, 256, 0, dod::slot_map_layout_dense_meta> dense;
+    dod::slot_map64<uint64_t, 256, 0> split;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        auto k1 = dense.emplace(i);
+        auto k2 = split.emplace(i);
+        EXPECT_EQ(k1, k2);
+    }
+
+    auto m1 = dense.memory_stats();
+    auto m2 = split.memory_stats();
+    EXPECT_EQ(m1.valueBytesReserved, m2.valueBytesReserved);
+    // pages hold values and live slots bitmaps only
+    EXPECT_LT(m1.pageBytesReserved, m2.pageBytesReserved);
+    EXPECT_GE(m1.metaTableBytes, size_t(4 * 256 + 1) * sizeof(uint32_t));
+    EXPECT_EQ(m2.metaTableBytes, size_t(0));
+    EXPECT_EQ(m1.totalBytes, m1.pageBytesReserved + m1.pagesVectorBytes + m1.metaTableBytes + m1.freeIndicesBytes);
+}
+
+TEST(SlotMapTest, ContiguousLayout)
+{
+    auto makeInt = [](int v) { return v; };
+    auto makeString = [](int v) { return std::string("value_") + std::to_string(v); };
+    auto makeByte = [](int v) { return uint8_t(v & 0xff); };
+
+    runLayoutWorkload<dod::slot_map64<int, 64, 16, dod::slot_map_layout_contiguous>>(makeInt);
+    runLayoutWorkload<dod::slot_map64<std::string, 64, 16, dod::slot_map_layout_contiguous>>(makeString);
+    runLayoutWorkload<dod::slot_map32<uint8_t, 64, 16, dod::slot_map_layout_contiguous>>(makeByte);
+    runLayoutWorkload<dod::slot_map32<std::string, 4096, 64, dod::slot_map_layout_contiguous>>(makeString);
+
+    // values are moved when the storage grows, but keys stay valid
+    using Map = dod::slot_map32<std::string, 16, 0, dod::slot_map_layout_contiguous>;
+    Map slotMap;
+    std::vector<Map::key> keys;
+    for (int i = 0; i < 1000; i++)
+    {
+        keys.emplace_back(slotMap.emplace(makeString(i)));
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        ASSERT_NE(slotMap.get(keys[i]), nullptr);
+        EXPECT_EQ(*slotMap.get(keys[i]), makeString(i));
+    }
+
+    // a single linear stream: values of the consecutive pages are adjacent
+    const std::string* prev = nullptr;
+    for (const std::string& v : slotMap)
+    {
+        if (prev)
+        {
+            EXPECT_EQ(prev + 1, &v);
+        }
+        prev = &v;
+    }
+
+    // version overflow releases pages, keys of the released pages must never match
+    std::vector<Map::key> oldKeys;
+    while (slotMap.stats().numInactivePages == 0)
+    {
+        auto k = slotMap.emplace("tmp");
+        oldKeys.emplace_back(k);
+        slotMap.erase(k);
+    }
+    for (const auto& k : oldKeys)
+    {
+        EXPECT_FALSE(slotMap.has_key(k));
+    }
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        ASSERT_NE(slotMap.get(keys[i]), nullptr);
+        EXPECT_EQ(*slotMap.get(keys[i]), makeString(int(i)));
+    }
+    slotMap.debug_stats();
+
+    Map moved(std::move(slotMap));
+    EXPECT_TRUE(slotMap.empty());
+    ASSERT_FALSE(keys.empty());
+    EXPECT_EQ(*moved.get(keys[0]), makeString(0));
+    moved.reset();
+    EXPECT_EQ(moved.memory_stats().pageBytesReserved, size_t(0));
+}
+
+namespace
+{
+// copies throw on request, the move constructor is not noexcept (so the values are copied when the contiguous storage grows)
+struct ThrowingCopy
+{
+    static inline int numAlive = 0;
+    static inline int numCopiesBeforeThrow = -1;
+    int value;
+
+    explicit ThrowingCopy(int v)
+        : value(v)
+    {
+        numAlive++;
+    }
+    ThrowingCopy(const ThrowingCopy& other)
+        : value(other.value)
+    {
+        if (numCopiesBeforeThrow == 0)
+        {
+            throw std::runtime_error("ThrowingCopy");
+        }
+        numCopiesBeforeThrow--;
+        numAlive++;
+    }
+    ThrowingCopy(ThrowingCopy&& other)
+        : ThrowingCopy(static_cast<const ThrowingCopy&>(other))
+    {
+    }
+    ~ThrowingCopy() { numAlive--; }
+};
+} // namespace
+
+TEST(SlotMapTest, ContiguousLayoutGrowThrows)
+{
+    using Map = dod::slot_map32<ThrowingCopy, 16, 0, dod::slot_map_layout_contiguous>;
+    static_assert(!std::is_nothrow_move_constructible<ThrowingCopy>::value, "ThrowingCopy must not be nothrow movable");
+    {
+        Map slotMap;
+        std::vector<Map::key> keys;
+        for (int i = 0; i < 16 * 4; i++)
+        {
+            keys.emplace_back(slotMap.emplace(i));
+        }
+        EXPECT_EQ(ThrowingCopy::numAlive, 16 * 4);
+
+        // the 5th page grows the storage, a copy in the middle of the relocation throws
+        ThrowingCopy::numCopiesBeforeThrow = 40;
+        EXPECT_THROW(slotMap.emplace(1000), std::runtime_error);
+        ThrowingCopy::numCopiesBeforeThrow = -1;
+
+        // the map is untouched
+        EXPECT_EQ(ThrowingCopy::numAlive, 16 * 4);
+        EXPECT_EQ(slotMap.size(), size_t(16 * 4));
+        for (int i = 0; i < 16 * 4; i++)
+        {
+            ASSERT_NE(slotMap.get(keys[i]), nullptr);
+            EXPECT_EQ(slotMap.get(keys[i])->value, i);
+        }
+
+        // and keeps growing
+        for (int i = 0; i < 16 * 4; i++)
+        {
+            keys.emplace_back(slotMap.emplace(16 * 4 + i));
+        }
+        for (int i = 0; i < 16 * 8; i++)
+        {
+            ASSERT_NE(slotMap.get(keys[i]), nullptr);
+            EXPECT_EQ(slotMap.get(keys[i])->value, i);
+        }
+        EXPECT_EQ(ThrowingCopy::numAlive, 16 * 8);
+    }
+    EXPECT_EQ(ThrowingCopy::numAlive, 0);
+}
+
+namespace
+{
+struct BigValue
+{
+    uint8_t data[3000];
+};
+
+template <typename T, size_t PAGEBYTES, typename Key, typename Layout> void checkPageBytesFor()
+{
+    using Map = dod::slot_map<T, Key, dod::slot_map_page_size_for_bytes<T, Key, Layout>(PAGEBYTES), 64, Layout>;
+    using DoubleMap = dod::slot_map<T, Key, Map::kPageSize * 2, 64, Layout>;
+    static_assert((Map::kPageSize & (Map::kPageSize - 1)) == 0, "Page size must be a power of two");
+    EXPECT_LE(Map::page_size_in_bytes(), PAGEBYTES);
+    // the largest page size that fits the budget
+    EXPECT_GT(DoubleMap::page_size_in_bytes(), PAGEBYTES);
+}
+
+template <typename T, size_t PAGEBYTES, typename Layout> void checkPageBytesForLayout()
+{
+    checkPageBytesFor<T, PAGEBYTES, dod::slot_map_key32<T>, Layout>();
+    checkPageBytesFor<T, PAGEBYTES, dod::slot_map_key64<T>, Layout>();
+    static_assert(dod::slot_map32_page_bytes<T, PAGEBYTES, 64, Layout>::page_size_in_bytes() <= PAGEBYTES, "Page is over the budget");
+    static_assert(dod::slot_map64_page_bytes<T, PAGEBYTES, 64, Layout>::page_size_in_bytes() <= PAGEBYTES, "Page is over the budget");
+}
+
+template <typename T, size_t PAGEBYTES> void checkPageBytes()
+{
+    checkPageBytesForLayout<T, PAGEBYTES, dod::slot_map_layout_split>();
+    checkPageBytesForLayout<T, PAGEBYTES, dod::slot_map_layout_interleaved>();
+    checkPageBytesForLayout<T, PAGEBYTES, dod::slot_map_layout_dense_meta>();
+    checkPageBytesForLayout<T, PAGEBYTES, dod::slot_map_layout_contiguous>();
+}
+} // namespace
+
+TEST(SlotMapTest, PageSizeFromByteBudget)
+{
+    checkPageBytes<int, 64 * 1024>();
+    checkPageBytes<std::string, 64 * 1024>();
+    checkPageBytes<BigValue, 64 * 1024>();
+    checkPageBytes<uint8_t, 2 * 1024 * 1024>();
+    checkPageBytes<BigValue, 2 * 1024 * 1024>();
+    // interleaved records are padded to the value alignment
+    checkPageBytes<double, 64 * 1024>();
+    checkPageBytes<uint8_t, 64 * 1024>();
+
+    // 8 bytes per slot (int + 32-bit version), 8192 slots + bitmap would not fit
+    static_assert(dod::slot_map_page_size_for_bytes<int>(64 * 1024) == 4096, "Unexpected page size");
+    static_assert(dod::slot_map_page_size_for_bytes<BigValue>(1024) == 1, "Values bigger than the budget get one element per page");
+
+    dod::slot_map32_page_bytes<BigValue, 64 * 1024> bigValues;
+    auto k = bigValues.emplace();
+    EXPECT_TRUE(bigValues.has_key(k));
+    EXPECT_LE(bigValues.memory_stats().pageBytesReserved, size_t(64 * 1024));
+}
@@ -0,0 +1,323 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <random>
+#include <slot_map_page_pool.h>
+#include <soa_slot_map.h>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+struct Position
+{
+    float x;
+    float y;
+};
+
+// counts outstanding bytes
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    size_t numAllocations = 0;
+    size_t outstandingBytes = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        numAllocations++;
+        outstandingBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        outstandingBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// throws from the constructor when asked to, counts live instances
+struct Throwing
+{
+    static inline int numAlive = 0;
+
+    explicit Throwing(bool shouldThrow)
+    {
+        if (shouldThrow)
+        {
+            throw std::runtime_error("Throwing");
+        }
+        numAlive++;
+    }
+    Throwing(const Throwing&) { numAlive++; }
+    ~Throwing() { numAlive--; }
+};
+} // namespace
+
+TEST(SlotMapTest, SoaBasic)
+{
+    using Entities = dod::soa_slot_map<std::tuple<Position, int, std::string>>;
+    Entities entities;
+    EXPECT_TRUE(entities.empty());
+
+    auto e1 = entities.emplace(Position{1.0f, 2.0f}, 10, "first");
+    auto e2 = entities.emplace(Position{3.0f, 4.0f}, 20, "second");
+    EXPECT_EQ(entities.size(), 2u);
+    EXPECT_TRUE(entities.has_key(e1));
+    EXPECT_TRUE(entities.has_key(e2));
+
+    ASSERT_NE(entities.get<0>(e1), nullptr);
+    EXPECT_EQ(entities.get<0>(e1)->x, 1.0f);
+    EXPECT_EQ(*entities.get<1>(e2), 20);
+    EXPECT_EQ(*entities.get<2>(e2), "second");
+
+    *entities.get<1>(e1) = 11;
+    EXPECT_EQ(*entities.get<1>(e1), 11);
+
+    entities.erase(e1);
+    EXPECT_FALSE(entities.has_key(e1));
+    EXPECT_EQ(entities.get<0>(e1), nullptr);
+    EXPECT_EQ(entities.get<2>(e1), nullptr);
+    EXPECT_EQ(entities.size(), 1u);
+
+    // erasing twice is a no-op
+    entities.erase(e1);
+    EXPECT_EQ(entities.size(), 1u);
+
+    // touches the selected components only
+    int sum = 0;
+    size_t numVisited = 0;
+    entities.for_each<1, 2>([&](int& v, std::string& s) {
+        sum += v;
+        s += "!";
+        numVisited++;
+    });
+    EXPECT_EQ(numVisited, size_t(1));
+    EXPECT_EQ(sum, 20);
+    EXPECT_EQ(*entities.get<2>(e2), "second!");
+
+    entities.clear();
+    EXPECT_TRUE(entities.empty());
+    EXPECT_FALSE(entities.has_key(e2));
+    entities.reset();
+    EXPECT_EQ(entities.num_pages(), 0u);
+}
+
+TEST(SlotMapTest, SoaPageSpans)
+{
+    using Particles = dod::soa_slot_map64<std::tuple<Position, Position, uint8_t>, 128, 0>;
+    Particles particles;
+    std::vector<Particles::key> keys;
+    for (int i = 0; i < 300; i++)
+    {
+        keys.emplace_back(particles.emplace(Position{float(i), 0.0f}, Position{1.0f, 2.0f}, uint8_t(i & 0xff)));
+    }
+    // remove every third particle
+    for (size_t i = 0; i < keys.size(); i += 3)
+    {
+        particles.erase(keys[i]);
+    }
+
+    ASSERT_EQ(particles.num_pages(), 3u);
+    size_t numAlive = 0;
+    for (Particles::size_type page = 0; page < particles.num_pages(); page++)
+    {
+        auto positions = particles.page_component<0>(page);
+        auto velocities = particles.page_component<1>(page);
+        auto bytes = particles.page_component<2>(page);
+        EXPECT_EQ(positions.size(), velocities.size());
+        EXPECT_EQ(positions.size(), bytes.size());
+        EXPECT_EQ(uintptr_t(positions.data()) % Particles::kComponentAlignment, uintptr_t(0));
+        EXPECT_EQ(uintptr_t(velocities.data()) % Particles::kComponentAlignment, uintptr_t(0));
+        EXPECT_EQ(uintptr_t(bytes.data()) % Particles::kComponentAlignment, uintptr_t(0));
+
+        // unconditional (vectorizable) loop over all the used slots
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            positions[i].x += velocities[i].x;
+            positions[i].y += velocities[i].y;
+        }
+        for (Particles::size_type i = 0; i < Particles::size_type(positions.size()); i++)
+        {
+            numAlive += particles.is_alive(page, i) ? 1 : 0;
+        }
+    }
+    EXPECT_EQ(numAlive, size_t(particles.size()));
+    // last page is partially used
+    EXPECT_EQ(particles.page_component<0>(2).size(), size_t(300 - 256));
+
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        const Position* p = particles.get<0>(keys[i]);
+        if ((i % 3) == 0)
+        {
+            EXPECT_EQ(p, nullptr);
+            continue;
+        }
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p->x, float(i) + 1.0f);
+        EXPECT_EQ(p->y, 2.0f);
+    }
+}
+
+TEST(SlotMapTest, SoaRandomWorkload)
+{
+    // small pages + 32-bit keys = pages are released because of version overflow
+    using Map = dod::soa_slot_map32<std::tuple<int, std::string>, 16, 4>;
+    using key = Map::key;
+    Map slotMap;
+    std::unordered_map<key, int> reference;
+    std::vector<key> removed;
+    std::mt19937 rng(7);
+
+    // churn a few slots until their versions overflow
+    for (int step = 0; step < 40000; step++)
+    {
+        key k = slotMap.emplace(step, std::to_string(step));
+        slotMap.erase(k);
+        removed.emplace_back(k);
+    }
+    EXPECT_GT(slotMap.stats().numInactivePages, 0u);
+
+    for (int step = 0; step < 100000; step++)
+    {
+        uint32_t op = rng() % 10;
+        if (op < 5 || reference.empty())
+        {
+            key k = slotMap.emplace(step, std::to_string(step));
+            ASSERT_EQ(reference.count(k), size_t(0));
+            reference[k] = step;
+        }
+        else if (op < 9)
+        {
+            auto it = reference.begin();
+            std::advance(it, rng() % reference.size());
+            slotMap.erase(it->first);
+            removed.emplace_back(it->first);
+            reference.erase(it);
+        }
+        else if (reference.size() > 64)
+        {
+            slotMap.clear();
+            for (const auto& kv : reference)
+            {
+                removed.emplace_back(kv.first);
+            }
+            reference.clear();
+        }
+    }
+
+    auto validate = [&](const Map& m) {
+        ASSERT_EQ(size_t(m.size()), reference.size());
+        for (const auto& kv : reference)
+        {
+            ASSERT_NE(m.get<0>(kv.first), nullptr);
+            EXPECT_EQ(*m.get<0>(kv.first), kv.second);
+            EXPECT_EQ(*m.get<1>(kv.first), std::to_string(kv.second));
+        }
+        for (const key& k : removed)
+        {
+            EXPECT_FALSE(m.has_key(k));
+            EXPECT_EQ(m.get<1>(k), nullptr);
+        }
+        size_t numVisited = 0;
+        m.for_each<0, 1>([&](const int& v, const std::string& s) {
+            EXPECT_EQ(std::to_string(v), s);
+            numVisited++;
+        });
+        EXPECT_EQ(numVisited, reference.size());
+    };
+    validate(slotMap);
+
+    // copy / move / swap
+    Map copy(slotMap);
+    validate(copy);
+    Map moved(std::move(copy));
+    validate(moved);
+    EXPECT_TRUE(copy.empty());
+    Map other;
+    other.swap(moved);
+    validate(other);
+    EXPECT_TRUE(moved.empty());
+    Map assigned;
+    assigned.emplace(1, "1");
+    assigned = other;
+    validate(assigned);
+
+    // the swapped map must keep handling page releases
+    for (const auto& kv : reference)
+    {
+        other.erase(kv.first);
+    }
+    EXPECT_TRUE(other.empty());
+    other.reset();
+    EXPECT_EQ(other.num_pages(), 0u);
+}
+
+TEST(SlotMapTest, SoaMemoryResource)
+{
+    using Map = dod::soa_slot_map<std::tuple<int, std::string>, dod::slot_map_key64<int>, 64>;
+    CountingResource resource;
+    {
+        Map slotMap(&resource);
+        EXPECT_EQ(slotMap.get_memory_resource(), &resource);
+        for (int i = 0; i < 1000; i++)
+        {
+            slotMap.emplace(i, std::to_string(i));
+        }
+        size_t numAllocations = resource.numAllocations;
+        // every slot page and every component page comes from the resource
+        EXPECT_GE(numAllocations, size_t(2) * slotMap.num_pages());
+
+        Map copy(slotMap);
+        EXPECT_EQ(copy.get_memory_resource(), &resource);
+        EXPECT_GE(resource.numAllocations, numAllocations + size_t(2) * copy.num_pages());
+        EXPECT_EQ(copy.size(), slotMap.size());
+    }
+    EXPECT_EQ(resource.outstandingBytes, size_t(0));
+
+    // the page allocator takes precedence over the memory resource
+    dod::slot_map_page_pool pool;
+    {
+        Map slotMap;
+        slotMap.set_page_allocator(&pool);
+        EXPECT_EQ(slotMap.get_page_allocator(), &pool);
+        for (int i = 0; i < 1000; i++)
+        {
+            slotMap.emplace(i, std::to_string(i));
+        }
+        Map moved(std::move(slotMap));
+        EXPECT_EQ(moved.get_page_allocator(), &pool);
+        EXPECT_GE(pool.stats().numSystemAllocations, uint64_t(2) * moved.num_pages());
+    }
+}
+
+TEST(SlotMapTest, SoaEmplaceThrows)
+{
+    using Map = dod::soa_slot_map<std::tuple<Throwing, std::string, Throwing>>;
+    Map slotMap;
+    auto k1 = slotMap.emplace(false, "a", false);
+    EXPECT_EQ(Throwing::numAlive, 2);
+
+    // the first component is destroyed, the slot is released
+    EXPECT_THROW(slotMap.emplace(false, "b", true), std::runtime_error);
+    EXPECT_EQ(Throwing::numAlive, 2);
+    EXPECT_EQ(slotMap.size(), 1u);
+    EXPECT_THROW(slotMap.emplace(true, "c", false), std::runtime_error);
+    EXPECT_EQ(Throwing::numAlive, 2);
+    EXPECT_EQ(slotMap.size(), 1u);
+
+    auto k2 = slotMap.emplace(false, "d", false);
+    EXPECT_TRUE(slotMap.has_key(k1));
+    EXPECT_TRUE(slotMap.has_key(k2));
+    EXPECT_EQ(*slotMap.get<1>(k2), "d");
+    EXPECT_EQ(Throwing::numAlive, 4);
+    size_t numVisited = 0;
+    slotMap.for_each<1>([&](const std::string&) { numVisited++; });
+    EXPECT_EQ(numVisited, 2u);
+    slotMap.reset();
+    EXPECT_EQ(Throwing::numAlive, 0);
+}
@@ -0,0 +1,161 @@
+#include <dense_slot_map.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+TEST(SlotMapTest, DenseBasic)
+{
+    dod::dense_slot_map<std::string> strings;
+    EXPECT_TRUE(strings.empty());
+
+    auto red = strings.emplace("Red");
+    auto green = strings.emplace("Green");
+    auto blue = strings.emplace("Blue");
+    EXPECT_EQ(strings.size(), 3u);
+    EXPECT_EQ(*strings.get(red), "Red");
+    EXPECT_EQ(*strings.get(green), "Green");
+
+    // the last value is moved into the erased position
+    strings.erase(red);
+    EXPECT_FALSE(strings.has_key(red));
+    EXPECT_EQ(strings.get(red), nullptr);
+    ASSERT_EQ(strings.size(), 2u);
+    EXPECT_EQ(strings.data()[0], "Blue");
+    EXPECT_EQ(strings.keys()[0], blue);
+    EXPECT_EQ(strings.data()[1], "Green");
+    EXPECT_EQ(strings.keys()[1], green);
+    EXPECT_EQ(*strings.get(blue), "Blue");
+
+    // erasing twice is a no-op
+    strings.erase(red);
+    EXPECT_EQ(strings.size(), 2u);
+
+    std::optional<std::string> popped = strings.pop(green);
+    ASSERT_TRUE(popped.has_value());
+    EXPECT_EQ(*popped, "Green");
+    EXPECT_FALSE(strings.pop(green).has_value());
+    EXPECT_EQ(strings.size(), 1u);
+
+    for (std::string& s : strings)
+    {
+        s += "!";
+    }
+    EXPECT_EQ(*strings.get(blue), "Blue!");
+
+    strings.clear();
+    EXPECT_TRUE(strings.empty());
+    EXPECT_FALSE(strings.has_key(blue));
+    strings.reset();
+    EXPECT_EQ(strings.stats().numPagesTotal, 0u);
+}
+
+TEST(SlotMapTest, DenseRandomWorkload)
+{
+    // small pages + 32-bit keys = slots get deactivated because of version overflow
+    using Map = dod::dense_slot_map32<std::string, 16, 4>;
+    using key = Map::key;
+    Map slotMap;
+    std::unordered_map<key, int> reference;
+    std::vector<key> removed;
+    std::mt19937 rng(11);
+
+    for (int step = 0; step < 40000; step++)
+    {
+        key k = slotMap.emplace(std::to_string(step));
+        slotMap.erase(k);
+        removed.emplace_back(k);
+    }
+    EXPECT_GT(slotMap.stats().numInactivePages, 0u);
+
+    for (int step = 0; step < 100000; step++)
+    {
+        uint32_t op = rng() % 10;
+        if (op < 5 || reference.empty())
+        {
+            key k = slotMap.emplace(std::to_string(step));
+            ASSERT_EQ(reference.count(k), size_t(0));
+            reference[k] = step;
+        }
+        else if (op < 9)
+        {
+            auto it = reference.begin();
+            std::advance(it, rng() % reference.size());
+            slotMap.erase(it->first);
+            removed.emplace_back(it->first);
+            reference.erase(it);
+        }
+        else if (reference.size() > 64)
+        {
+            slotMap.clear();
+            for (const auto& kv : reference)
+            {
+                removed.emplace_back(kv.first);
+            }
+            reference.clear();
+        }
+    }
+
+    auto validate = [&](const Map& m) {
+        ASSERT_EQ(size_t(m.size()), reference.size());
+        for (const auto& kv : reference)
+        {
+            ASSERT_NE(m.get(kv.first), nullptr);
+            EXPECT_EQ(*m.get(kv.first), std::to_string(kv.second));
+        }
+        for (const key& k : removed)
+        {
+            EXPECT_FALSE(m.has_key(k));
+        }
+        // dense arrays are gap-free and consistent with the keys
+        for (Map::size_type i = 0; i < m.size(); i++)
+        {
+            auto it = reference.find(m.keys()[i]);
+            ASSERT_NE(it, reference.end());
+            EXPECT_EQ(m.data()[i], std::to_string(it->second));
+            EXPECT_EQ(m.get(m.keys()[i]), &m.data()[i]);
+        }
+    };
+    validate(slotMap);
+
+    Map copy(slotMap);
+    validate(copy);
+    Map moved(std::move(copy));
+    validate(moved);
+    Map other;
+    other.swap(moved);
+    validate(other);
+    EXPECT_TRUE(moved.empty());
+}
+
+TEST(SlotMapTest, DenseEmplaceThrows)
+{
+    struct Value
+    {
+        explicit Value(int _v)
+            : v(_v)
+        {
+            if (v < 0)
+            {
+                throw std::runtime_error("Value");
+            }
+        }
+        int v;
+    };
+    dod::dense_slot_map<Value> slotMap;
+    std::vector<dod::dense_slot_map<Value>::key> keys;
+    for (int i = 0; i < 100; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+        EXPECT_THROW(slotMap.emplace(-1), std::runtime_error);
+        EXPECT_EQ(slotMap.size(), keys.size());
+    }
+    EXPECT_EQ(slotMap.stats().numAliveItems, keys.size());
+    for (int i = 0; i < 100; i++)
+    {
+        ASSERT_NE(slotMap.get(keys[i]), nullptr);
+        EXPECT_EQ(slotMap.get(keys[i])->v, i);
+        EXPECT_EQ(slotMap.keys()[i], keys[i]);
+    }
+}
@@ -0,0 +1,265 @@
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <slot_map_page_pool.h>
+#include <string>
+#include <thread>
+
+TEST(SlotMapTest, PagePoolReuse)
+{
+    dod::slot_map_page_pool pool;
+
+    // level load/unload cycles
+    for (int cycle = 0; cycle < 10; cycle++)
+    {
+        dod::slot_map<int, dod::slot_map_key64<int>, 256> ints;
+        ints.set_page_allocator(&pool);
+        dod::slot_map<std::string, dod::slot_map_key64<std::string>, 64> strings;
+        strings.set_page_allocator(&pool);
+        EXPECT_EQ(ints.get_page_allocator(), &pool);
+
+        std::vector<dod::slot_map<int, dod::slot_map_key64<int>, 256>::key> keys;
+        for (int i = 0; i < 5000; i++)
+        {
+            keys.emplace_back(ints.emplace(i));
+            strings.emplace(std::to_string(i));
+        }
+        for (int i = 0; i < 5000; i++)
+        {
+            EXPECT_EQ(*ints.get(keys[i]), i);
+        }
+
+        // copies and moved maps keep using the pool
+        auto copy = ints;
+        EXPECT_EQ(copy.get_page_allocator(), &pool);
+        auto moved = std::move(copy);
+        EXPECT_EQ(moved.get_page_allocator(), &pool);
+        EXPECT_EQ(*moved.get(keys[0]), 0);
+    }
+
+    // 20 pages of ints (x2 for the copy) + 79 pages of strings, everything after the first cycle is recycled
+    dod::slot_map_page_pool::Stats stats = pool.stats();
+    EXPECT_EQ(stats.numSystemAllocations, uint64_t(20 * 2 + 79));
+    EXPECT_EQ(stats.numReused, uint64_t(9 * (20 * 2 + 79)));
+    EXPECT_EQ(stats.numSystemFrees, uint64_t(0));
+
+    pool.trim();
+    stats = pool.stats();
+    EXPECT_EQ(stats.numCachedBlocks, size_t(0));
+    EXPECT_EQ(stats.cachedBytes, size_t(0));
+    EXPECT_EQ(stats.numSystemFrees, stats.numSystemAllocations);
+}
+
+TEST(SlotMapTest, PagePoolPartialTrimAndRelease)
+{
+    dod::slot_map_page_pool pool;
+    using Map = dod::slot_map32<uint64_t, 16, 0>;
+    size_t pageBytes = Map::page_size_in_bytes();
+    {
+        Map slotMap;
+        slotMap.set_page_allocator(&pool);
+        for (uint64_t i = 0; i < 16 * 64; i++)
+        {
+            slotMap.emplace(i);
+        }
+        // pages released on version overflow go back to the pool
+        auto k = slotMap.emplace(uint64_t(0));
+        while (slotMap.stats().numInactivePages == 0)
+        {
+            slotMap.erase(k);
+            k = slotMap.emplace(uint64_t(0));
+        }
+        EXPECT_GT(pool.stats().numReused + pool.stats().numCachedBlocks, uint64_t(0));
+    }
+
+    // keep two pages cached
+    pool.trim(pageBytes * 2);
+    EXPECT_LE(pool.stats().cachedBytes, pageBytes * 2);
+    EXPECT_EQ(pool.stats().numCachedBlocks, size_t(2));
+
+    // switching allocators: old pages are returned to the allocator they came from
+    Map slotMap;
+    slotMap.set_page_allocator(&pool);
+    auto k1 = slotMap.emplace(uint64_t(1));
+    slotMap.set_page_allocator(nullptr);
+    for (uint64_t i = 0; i < 64; i++)
+    {
+        slotMap.emplace(i);
+    }
+    EXPECT_EQ(*slotMap.get(k1), uint64_t(1));
+    slotMap.reset();
+    // the first page went back to the pool (thread cache), trim flushes it into the shared lists
+    pool.trim(pageBytes * 2);
+    EXPECT_EQ(pool.stats().numCachedBlocks, size_t(2));
+}
+
+TEST(SlotMapTest, PagePoolThreads)
+{
+    dod::slot_map_page_pool pool;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&pool, t]() {
+            for (int cycle = 0; cycle < 20; cycle++)
+            {
+                dod::slot_map<int, dod::slot_map_key64<int>, 128> slotMap;
+                slotMap.set_page_allocator(&pool);
+                for (int i = 0; i < 1000; i++)
+                {
+                    slotMap.emplace(i + t);
+                }
+                int sum = 0;
+                for (int v : slotMap)
+                {
+                    sum += v - t;
+                }
+                EXPECT_EQ(sum, 999 * 1000 / 2);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    dod::slot_map_page_pool::Stats stats = pool.stats();
+    // 4 threads * 20 cycles * 8 pages
+    EXPECT_EQ(stats.numSystemAllocations + stats.numReused, uint64_t(4 * 20 * 8));
+    EXPECT_LT(stats.numSystemAllocations, uint64_t(4 * 20 * 8));
+}
+
+TEST(SlotMapTest, PagePoolThreadCacheSizeClasses)
+{
+    dod::slot_map_page_pool pool;
+    const size_t kNumClasses = dod::slot_map_page_pool::kThreadCacheNumClasses;
+    std::thread([&]() {
+        // every size class a thread uses at once is recycled through its cache
+        for (int cycle = 0; cycle < 3; cycle++)
+        {
+            std::vector<void*> blocks;
+            for (size_t i = 0; i < kNumClasses; i++)
+            {
+                blocks.push_back(pool.allocate_page(1024 * (i + 1), 64));
+            }
+            for (size_t i = 0; i < kNumClasses; i++)
+            {
+                pool.free_page(blocks[i], 1024 * (i + 1), 64);
+            }
+            EXPECT_EQ(pool.stats().numCachedBlocks, size_t(0));
+        }
+        EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(kNumClasses));
+
+        // one more size class goes to the shared lists
+        void* extra = pool.allocate_page(1024 * (kNumClasses + 1), 64);
+        pool.free_page(extra, 1024 * (kNumClasses + 1), 64);
+        EXPECT_EQ(pool.stats().numCachedBlocks, size_t(1));
+    }).join();
+
+    // the thread exited, its cached blocks were moved to the shared lists
+    EXPECT_EQ(pool.stats().numCachedBlocks, kNumClasses + 1);
+    pool.trim();
+    EXPECT_EQ(pool.stats().numSystemFrees, uint64_t(kNumClasses + 1));
+}
+
+TEST(SlotMapTest, PagePoolDestroyedOnAnotherThread)
+{
+    using Map = dod::slot_map<int, dod::slot_map_key64<int>, 256>;
+    auto levelPool = std::make_unique<dod::slot_map_page_pool>();
+    {
+        // the pages end up in this thread's cache
+        Map slotMap;
+        slotMap.set_page_allocator(levelPool.get());
+        for (int i = 0; i < 256 * 4; i++)
+        {
+            slotMap.emplace(i);
+        }
+    }
+    EXPECT_EQ(levelPool->stats().numCachedBlocks, size_t(0));
+
+    // the pool dies on another thread and reclaims the blocks cached by this thread
+    std::thread([&levelPool]() { levelPool.reset(); }).join();
+
+    // the thread cache is rebound to the new pool (nothing goes to the shared lists)
+    dod::slot_map_page_pool pool;
+    {
+        Map slotMap;
+        slotMap.set_page_allocator(&pool);
+        slotMap.emplace(1);
+    }
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(1));
+    EXPECT_EQ(pool.stats().numCachedBlocks, size_t(0));
+    {
+        Map slotMap;
+        slotMap.set_page_allocator(&pool);
+        slotMap.emplace(1);
+    }
+    EXPECT_EQ(pool.stats().numReused, uint64_t(1));
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(1));
+}
+
+TEST(SlotMapTest, PagePoolReclaimsOtherThreadCaches)
+{
+    using Map = dod::slot_map<int, dod::slot_map_key64<int>, 256>;
+    dod::slot_map_page_pool pool;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool pagesFreed = false;
+    bool trimmed = false;
+
+    // the worker keeps its pages in its thread cache and stays alive until the main thread trims the pool
+    std::thread worker([&]() {
+        {
+            Map slotMap;
+            slotMap.set_page_allocator(&pool);
+            for (int i = 0; i < 256 * 4; i++)
+            {
+                slotMap.emplace(i);
+            }
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        pagesFreed = true;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return trimmed; });
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return pagesFreed; });
+    }
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(4));
+    EXPECT_EQ(pool.stats().numCachedBlocks, size_t(0));
+    pool.trim();
+    EXPECT_EQ(pool.stats().numSystemFrees, uint64_t(4));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        trimmed = true;
+        cv.notify_all();
+    }
+    worker.join();
+
+    // blocks cached by an exited thread go back to the shared lists
+    std::thread([&]() {
+        Map slotMap;
+        slotMap.set_page_allocator(&pool);
+        slotMap.emplace(1);
+    }).join();
+    EXPECT_EQ(pool.stats().numCachedBlocks, size_t(1));
+    pool.trim();
+    EXPECT_EQ(pool.stats().numSystemFrees, pool.stats().numSystemAllocations);
+}
+
+namespace
+{
+// destroyed after the main thread's thread_local caches
+dod::slot_map_page_pool gStaticPool;
+dod::slot_map<int> gStaticPoolUser;
+} // namespace
+
+TEST(SlotMapTest, PagePoolStaticStorage)
+{
+    gStaticPoolUser.set_page_allocator(&gStaticPool);
+    gStaticPoolUser.emplace(1);
+    gStaticPoolUser.reset();
+    gStaticPoolUser.emplace(2);
+    EXPECT_EQ(gStaticPool.stats().numReused, uint64_t(1));
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <random>
+#include <slot_map.h>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+// counts outstanding allocations, checks that every block is returned with the same size and alignment
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    explicit CountingResource(std::pmr::memory_resource* _upstream = std::pmr::new_delete_resource())
+        : upstream(_upstream)
+    {
+    }
+    ~CountingResource() override { EXPECT_TRUE(blocks.empty()); }
+
+    size_t numAllocations = 0;
+    size_t outstandingBytes = 0;
+    std::unordered_map<void*, std::pair<size_t, size_t>> blocks;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* p = upstream->allocate(bytes, alignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, uintptr_t(0));
+        blocks[p] = {bytes, alignment};
+        numAllocations++;
+        outstandingBytes += bytes;
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        auto it = blocks.find(p);
+        EXPECT_NE(it, blocks.end());
+        if (it != blocks.end())
+        {
+            EXPECT_EQ(it->second.first, bytes);
+            EXPECT_EQ(it->second.second, alignment);
+            blocks.erase(it);
+        }
+        outstandingBytes -= bytes;
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream;
+};
+
+template <typename Map> void memoryResourceWorkload()
+{
+    using key = typename Map::key;
+    CountingResource resource;
+    {
+        Map slotMap(&resource);
+        EXPECT_EQ(slotMap.get_memory_resource(), &resource);
+        std::unordered_map<key, int> reference;
+        std::mt19937 rng(3);
+        for (int step = 0; step < 20000; step++)
+        {
+            if ((rng() % 3) != 0 || reference.empty())
+            {
+                key k = slotMap.emplace(std::to_string(step));
+                reference[k] = step;
+            }
+            else
+            {
+                auto it = reference.begin();
+                slotMap.erase(it->first);
+                reference.erase(it);
+            }
+        }
+        // pages, page table, (version table) and free indices queue
+        EXPECT_GE(resource.numAllocations, size_t(4));
+        EXPECT_GT(resource.outstandingBytes, size_t(0));
+
+        // copies inherit the resource
+        Map copy(slotMap);
+        EXPECT_EQ(copy.get_memory_resource(), &resource);
+        for (const auto& kv : reference)
+        {
+            ASSERT_NE(copy.get(kv.first), nullptr);
+            EXPECT_EQ(*copy.get(kv.first), std::to_string(kv.second));
+        }
+
+        // copy assignment keeps the resource of the destination
+        Map assigned;
+        assigned = copy;
+        EXPECT_EQ(assigned.get_memory_resource(), nullptr);
+        EXPECT_EQ(assigned.size(), copy.size());
+
+        // the resource follows the content
+        Map other;
+        other.swap(copy);
+        EXPECT_EQ(other.get_memory_resource(), &resource);
+        EXPECT_EQ(copy.get_memory_resource(), nullptr);
+        Map moved(std::move(other));
+        EXPECT_EQ(moved.get_memory_resource(), &resource);
+        EXPECT_EQ(moved.size(), slotMap.size());
+
+        // reset releases everything but keeps the resource
+        slotMap.reset();
+        EXPECT_EQ(slotMap.get_memory_resource(), &resource);
+        slotMap.emplace("after reset");
+        EXPECT_EQ(slotMap.size(), 1u);
+    }
+    EXPECT_EQ(resource.outstandingBytes, size_t(0));
+}
+} // namespace
+
+TEST(SlotMapTest, MemoryResource)
+{
+    memoryResourceWorkload<dod::slot_map<std::string, dod::slot_map_key64<std::string>, 64>>();
+    memoryResourceWorkload<dod::slot_map32<std::string, 16, 4, dod::slot_map_layout_interleaved>>();
+    memoryResourceWorkload<dod::slot_map<std::string, dod::slot_map_key64<std::string>, 64, 64, dod::slot_map_layout_dense_meta>>();
+    memoryResourceWorkload<dod::slot_map<std::string, dod::slot_map_key64<std::string>, 64, 64, dod::slot_map_layout_contiguous>>();
+}
+
+TEST(SlotMapTest, MemoryResourceMonotonicArena)
+{
+    // per-frame arena: nothing reaches the upstream resource until the arena runs out of space
+    alignas(64) static char buffer[1024 * 1024];
+    CountingResource upstream;
+    {
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), &upstream);
+        dod::slot_map<int, dod::slot_map_key64<int>, 256> slotMap(&arena);
+        std::vector<dod::slot_map_key64<int>> keys;
+        for (int i = 0; i < 10000; i++)
+        {
+            keys.emplace_back(slotMap.emplace(i));
+        }
+        for (int i = 0; i < 10000; i++)
+        {
+            EXPECT_EQ(*slotMap.get(keys[i]), i);
+        }
+        EXPECT_EQ(upstream.numAllocations, size_t(0));
+    }
+}
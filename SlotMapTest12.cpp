@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <slot_map_vm_allocator.h>
+#include <string>
+
+TEST(SlotMapTest, VmPageAllocator)
+{
+    using Map = dod::slot_map<uint64_t, dod::slot_map_key64<uint64_t>, 1024, 0>;
+    const size_t pageBytes = Map::page_size_in_bytes();
+    dod::slot_map_vm_page_allocator vm(pageBytes * 8);
+    if (vm.data() == nullptr)
+    {
+        GTEST_SKIP() << "virtual memory reservation is not supported";
+    }
+
+    {
+        Map slotMap;
+        slotMap.set_page_allocator(&vm);
+        std::vector<Map::key> keys;
+        for (uint64_t i = 0; i < Map::kPageSize * 4; i++)
+        {
+            keys.emplace_back(slotMap.emplace(i));
+        }
+
+        // pages are committed in order: base + page index * page size
+        const char* first = reinterpret_cast<const char*>(slotMap.get(keys[0]));
+        for (size_t page = 0; page < 4; page++)
+        {
+            const char* v = reinterpret_cast<const char*>(slotMap.get(keys[page * Map::kPageSize]));
+            EXPECT_TRUE(vm.contains(v));
+            EXPECT_EQ(size_t(v - first), page * pageBytes);
+        }
+        for (uint64_t i = 0; i < keys.size(); i++)
+        {
+            EXPECT_EQ(*slotMap.get(keys[i]), i);
+        }
+
+        dod::slot_map_vm_page_allocator::Stats stats = vm.stats();
+        EXPECT_EQ(stats.usedBytes, pageBytes * 4);
+        EXPECT_GE(stats.committedBytes, stats.usedBytes);
+        EXPECT_EQ(stats.numFallbackAllocations, uint64_t(0));
+
+        // released pages are reused
+        slotMap.reset();
+        for (uint64_t i = 0; i < Map::kPageSize * 2; i++)
+        {
+            slotMap.emplace(i);
+        }
+        stats = vm.stats();
+        EXPECT_EQ(stats.usedBytes, pageBytes * 4);
+        EXPECT_EQ(stats.numReused, uint64_t(2));
+
+        // pages beyond the reserved range fall back to SLOT_MAP_ALLOC
+        for (uint64_t i = 0; i < Map::kPageSize * 8; i++)
+        {
+            slotMap.emplace(i);
+        }
+        stats = vm.stats();
+        EXPECT_EQ(stats.usedBytes, pageBytes * 8);
+        EXPECT_EQ(stats.numFallbackAllocations, uint64_t(2));
+        EXPECT_EQ(slotMap.size(), Map::kPageSize * 10);
+    }
+}
+
+TEST(SlotMapTest, VmPageAllocatorSizeClasses)
+{
+    using Small = dod::slot_map<uint32_t, dod::slot_map_key64<uint32_t>, 256, 0>;
+    using Big = dod::slot_map<uint64_t, dod::slot_map_key64<uint64_t>, 1024, 0>;
+    dod::slot_map_vm_page_allocator vm(size_t(16) * 1024 * 1024);
+    if (vm.data() == nullptr)
+    {
+        GTEST_SKIP() << "virtual memory reservation is not supported";
+    }
+
+    // interleaved page churn of two page sizes, released pages are only reused by pages of the same size
+    for (int cycle = 0; cycle < 10; cycle++)
+    {
+        Small small;
+        small.set_page_allocator(&vm);
+        Big big;
+        big.set_page_allocator(&vm);
+        for (uint32_t i = 0; i < 1024 * 3; i++)
+        {
+            small.emplace(i);
+            big.emplace(uint64_t(i));
+        }
+        EXPECT_EQ(small.size(), 1024u * 3);
+        EXPECT_EQ(big.size(), 1024u * 3);
+    }
+    dod::slot_map_vm_page_allocator::Stats stats = vm.stats();
+    EXPECT_EQ(stats.usedBytes, Small::page_size_in_bytes() * 12 + Big::page_size_in_bytes() * 3);
+    EXPECT_EQ(stats.numReused, uint64_t(9 * (12 + 3)));
+    EXPECT_EQ(stats.numFallbackAllocations, uint64_t(0));
+    EXPECT_EQ(stats.numLostPages, uint64_t(0));
+
+    // a block released with a size this allocator never handed out is counted, not reused
+    void* page = vm.allocate_page(Small::page_size_in_bytes(), alignof(uint32_t));
+    vm.free_page(page, Small::page_size_in_bytes() * 2, alignof(uint32_t));
+    EXPECT_EQ(vm.stats().numLostPages, uint64_t(1));
+    EXPECT_NE(vm.allocate_page(Small::page_size_in_bytes() * 2, alignof(uint32_t)), page);
+}
+
+TEST(SlotMapTest, VmPageAllocatorHugePages)
+{
+    using Map = dod::slot_map64_page_bytes<std::string, dod::slot_map_vm_page_allocator::kHugePageSize>;
+    const uint32_t flags = dod::slot_map_vm_page_allocator::kTransparentHugePages | dod::slot_map_vm_page_allocator::kExplicitHugePages;
+    dod::slot_map_vm_page_allocator vm(size_t(64) * 1024 * 1024, flags);
+    if (vm.data() == nullptr)
+    {
+        GTEST_SKIP() << "virtual memory reservation is not supported";
+    }
+    // huge pages have to be naturally aligned
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(vm.data()) % dod::slot_map_vm_page_allocator::kHugePageSize, uintptr_t(0));
+
+    Map strings;
+    strings.set_page_allocator(&vm);
+    std::vector<Map::key> keys;
+    for (int i = 0; i < 200000; i++)
+    {
+        keys.emplace_back(strings.emplace(std::to_string(i)));
+    }
+    for (int i = 0; i < 200000; i++)
+    {
+        EXPECT_EQ(*strings.get(keys[i]), std::to_string(i));
+    }
+    dod::slot_map_vm_page_allocator::Stats stats = vm.stats();
+    EXPECT_EQ(stats.numFallbackAllocations, uint64_t(0));
+    EXPECT_EQ(stats.committedBytes % dod::slot_map_vm_page_allocator::kHugePageSize, size_t(0));
+    strings.reset();
+}
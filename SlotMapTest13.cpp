@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <slot_map.h>
+#include <string>
+
+namespace
+{
+class AllocationCounter : public std::pmr::memory_resource
+{
+  public:
+    size_t numAllocations = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        numAllocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override { std::pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+template <typename Map> void checkFifoReuse(Map& slotMap, const std::vector<typename Map::key>& erased)
+{
+    // recycled slots are reused in erase order (oldest first) once there are more than kMinFreeIndices of them
+    for (size_t i = 0; i < erased.size() - Map::kMinFreeIndices; i++)
+    {
+        typename Map::key k = slotMap.emplace();
+        EXPECT_EQ(Map::key::toIndex(k), Map::key::toIndex(erased[i]));
+        EXPECT_EQ(Map::key::toVersion(k), Map::key::toVersion(erased[i]) + 1);
+        EXPECT_FALSE(slotMap.has_key(erased[i]));
+    }
+    // the rest of the free slots are kept until enough indices are accumulated
+    typename Map::key k = slotMap.emplace();
+    EXPECT_GT(Map::key::toIndex(k), Map::key::toIndex(erased.back()));
+}
+} // namespace
+
+TEST(SlotMapTest, IntrusiveFreeListFifo)
+{
+    using Map = dod::slot_map64<std::string, 64, 8>;
+    Map slotMap;
+    std::vector<Map::key> keys;
+    for (int i = 0; i < 200; i++)
+    {
+        keys.emplace_back(slotMap.emplace(std::to_string(i)));
+    }
+    // erase in a scattered order
+    std::vector<Map::key> erased;
+    for (size_t i = 0; i < keys.size(); i += 7)
+    {
+        erased.emplace_back(keys[i]);
+    }
+    for (size_t i = 3; i < keys.size(); i += 7)
+    {
+        erased.emplace_back(keys[i]);
+    }
+    for (const Map::key& k : erased)
+    {
+        slotMap.erase(k);
+    }
+
+    // copies (non trivially copyable values) keep the free list order
+    Map copy(slotMap);
+    Map moved(std::move(copy));
+    checkFifoReuse(slotMap, erased);
+    checkFifoReuse(moved, erased);
+}
+
+TEST(SlotMapTest, IntrusiveFreeListSmallValues)
+{
+    // values smaller than the free list link
+    using Map = dod::slot_map32<uint8_t, 16, 4>;
+    Map slotMap;
+    std::vector<Map::key> keys;
+    for (int i = 0; i < 64; i++)
+    {
+        keys.emplace_back(slotMap.emplace(uint8_t(i)));
+    }
+    std::vector<Map::key> erased;
+    for (size_t i = 0; i < keys.size(); i += 2)
+    {
+        slotMap.erase(keys[i]);
+        erased.emplace_back(keys[i]);
+    }
+    for (size_t i = 1; i < keys.size(); i += 2)
+    {
+        EXPECT_EQ(*slotMap.get(keys[i]), uint8_t(i));
+    }
+    Map copy;
+    copy = slotMap;
+    checkFifoReuse(copy, erased);
+}
+
+TEST(SlotMapTest, IntrusiveFreeListNoAllocations)
+{
+    AllocationCounter counter;
+    dod::slot_map64<int, 1024, 64> slotMap(&counter);
+    std::vector<dod::slot_map64<int, 1024, 64>::key> keys;
+    for (int i = 0; i < 512; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+    size_t numAllocations = counter.numAllocations;
+
+    // steady state churn doesn't allocate
+    for (int step = 0; step < 100000; step++)
+    {
+        size_t i = size_t(step) % keys.size();
+        slotMap.erase(keys[i]);
+        keys[i] = slotMap.emplace(step);
+    }
+    EXPECT_EQ(counter.numAllocations, numAllocations);
+    EXPECT_EQ(slotMap.size(), 512u);
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <slot_map.h>
+#include <string>
+#include <unordered_map>
+
+TEST(SlotMapTest, DenseFirstReuse)
+{
+    using Map = dod::slot_map64<int, 64, 8>;
+    using key = Map::key;
+    Map slotMap;
+    EXPECT_EQ(slotMap.get_reuse_policy(), dod::slot_map_reuse_policy::fifo);
+    slotMap.set_reuse_policy(dod::slot_map_reuse_policy::dense_first);
+
+    std::vector<key> keys;
+    for (int i = 0; i < 64 * 4; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+
+    // pages 0 and 2 become sparse (4 alive slots), pages 1 and 3 lose 16 slots
+    std::vector<key> sparse;
+    for (size_t page = 0; page < 4; page++)
+    {
+        for (size_t i = 0; i < 64; i++)
+        {
+            key k = keys[page * 64 + i];
+            bool isSparsePage = (page % 2) == 0;
+            if ((isSparsePage && i >= 4) || (!isSparsePage && (i % 4) == 0))
+            {
+                slotMap.erase(k);
+            }
+            else if (isSparsePage)
+            {
+                sparse.emplace_back(k);
+            }
+        }
+    }
+
+    // the last 8 erased slots (page 3) are still resting, the dense pages are refilled first
+    for (int i = 0; i < 16 + 8; i++)
+    {
+        key k = slotMap.emplace(1000 + i);
+        size_t page = Map::key::toIndex(k) / 64;
+        EXPECT_TRUE(page == 1 || page == 3);
+    }
+
+    // sparse pages drain completely and are not refilled while the dense pages have free slots
+    for (const key& k : sparse)
+    {
+        slotMap.erase(k);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        key k = slotMap.emplace(2000 + i);
+        EXPECT_EQ(Map::key::toIndex(k) / 64, 3u);
+    }
+    std::vector<dod::slot_map64<int, 64, 8>::PageOccupancy> occupancy = slotMap.debug_page_occupancy();
+    ASSERT_EQ(occupancy.size(), size_t(4));
+    EXPECT_EQ(occupancy[0].numAliveItems, 0u);
+    EXPECT_EQ(occupancy[1].numAliveItems, 64u);
+    EXPECT_EQ(occupancy[2].numAliveItems, 0u);
+    EXPECT_EQ(occupancy[3].numAliveItems, 64u);
+    slotMap.debug_stats();
+
+    // switching back to fifo keeps all the recycled slots
+    slotMap.set_reuse_policy(dod::slot_map_reuse_policy::fifo);
+    slotMap.debug_stats();
+    for (int i = 0; i < 128 - 8; i++)
+    {
+        key k = slotMap.emplace(i);
+        size_t page = Map::key::toIndex(k) / 64;
+        EXPECT_TRUE(page == 0 || page == 2);
+    }
+    EXPECT_EQ(slotMap.debug_page_occupancy().size(), size_t(4));
+}
+
+TEST(SlotMapTest, DenseFirstRandomWorkload)
+{
+    // small pages + 32-bit keys = slots get deactivated because of version overflow
+    using Map = dod::slot_map32<std::string, 16, 4>;
+    using key = Map::key;
+    Map slotMap;
+    slotMap.set_reuse_policy(dod::slot_map_reuse_policy::dense_first);
+    std::unordered_map<key, int> reference;
+    std::vector<key> removed;
+    std::mt19937 rng(5);
+
+    for (int step = 0; step < 200000; step++)
+    {
+        uint32_t op = rng() % 100;
+        if (op < 50 || reference.empty())
+        {
+            key k = slotMap.emplace(std::to_string(step));
+            ASSERT_EQ(reference.count(k), size_t(0));
+            reference[k] = step;
+        }
+        else if (op < 98)
+        {
+            auto it = reference.begin();
+            std::advance(it, rng() % std::min(reference.size(), size_t(32)));
+            slotMap.erase(it->first);
+            removed.emplace_back(it->first);
+            reference.erase(it);
+        }
+        else if (op < 99)
+        {
+            // policy switches keep the recycled slots consistent
+            slotMap.set_reuse_policy((slotMap.get_reuse_policy() == dod::slot_map_reuse_policy::fifo) ? dod::slot_map_reuse_policy::dense_first
+                                                                                                      : dod::slot_map_reuse_policy::fifo);
+        }
+        else if (reference.size() > 64)
+        {
+            slotMap.clear();
+            for (const auto& kv : reference)
+            {
+                removed.emplace_back(kv.first);
+            }
+            reference.clear();
+        }
+    }
+    EXPECT_GT(slotMap.stats().numInactiveItems + slotMap.stats().numInactivePages, 0u);
+
+    auto validate = [&](Map& m) {
+        m.debug_stats();
+        ASSERT_EQ(size_t(m.size()), reference.size());
+        for (const auto& kv : reference)
+        {
+            ASSERT_NE(m.get(kv.first), nullptr);
+            EXPECT_EQ(*m.get(kv.first), std::to_string(kv.second));
+        }
+        for (const key& k : removed)
+        {
+            EXPECT_FALSE(m.has_key(k));
+        }
+        // keep using the map (copies must keep the reuse structures consistent)
+        for (int i = 0; i < 1000; i++)
+        {
+            key k = m.emplace("x");
+            m.erase(k);
+        }
+        m.debug_stats();
+    };
+
+    slotMap.set_reuse_policy(dod::slot_map_reuse_policy::dense_first);
+    Map copy(slotMap);
+    EXPECT_EQ(copy.get_reuse_policy(), dod::slot_map_reuse_policy::dense_first);
+    validate(copy);
+    Map moved(std::move(copy));
+    validate(moved);
+    Map other;
+    other.swap(moved);
+    validate(other);
+    Map assigned;
+    assigned = slotMap;
+    validate(assigned);
+    validate(slotMap);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include <slot_map.h>
+#include <vector>
+
+namespace
+{
+// bursty spawn/despawn of a small population followed by a steady state with a large population
+template <typename Map> void churnWorkload(Map& slotMap, std::vector<uint32_t>& thresholds)
+{
+    std::vector<typename Map::key> keys;
+    for (int burst = 0; burst < 2000; burst++)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            keys.emplace_back(slotMap.emplace(i));
+        }
+        for (const typename Map::key& k : keys)
+        {
+            slotMap.erase(k);
+        }
+        keys.clear();
+    }
+    thresholds.emplace_back(slotMap.get_min_free_indices());
+
+    for (int i = 0; i < 200000; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+    // steady state: a few items are replaced, versions barely move
+    for (int step = 0; step < 100000; step++)
+    {
+        size_t i = (size_t(step) * 7919) % keys.size();
+        slotMap.erase(keys[i]);
+        keys[i] = slotMap.emplace(step);
+    }
+    thresholds.emplace_back(slotMap.get_min_free_indices());
+}
+} // namespace
+
+TEST(SlotMapTest, AdaptiveMinFreeIndices)
+{
+    using Map = dod::slot_map32<int, 256, 4>;
+
+    Map fixed;
+    EXPECT_EQ(fixed.get_min_free_indices(), 4u);
+    std::vector<uint32_t> fixedThresholds;
+    churnWorkload(fixed, fixedThresholds);
+    EXPECT_EQ(fixedThresholds[0], 4u);
+    EXPECT_EQ(fixedThresholds[1], 4u);
+
+    Map adaptive;
+    adaptive.enable_adaptive_min_free_indices(4, 4096);
+    std::vector<uint32_t> adaptiveThresholds;
+    churnWorkload(adaptive, adaptiveThresholds);
+
+    // bursty phase: the threshold grows (slots rest longer), so fewer slots are retired because of version overflow
+    EXPECT_GT(adaptiveThresholds[0], 4u);
+    EXPECT_LE(adaptiveThresholds[0], 4096u);
+    EXPECT_LT(adaptive.stats().numInactiveItems + adaptive.stats().numInactivePages * Map::kPageSize,
+              fixed.stats().numInactiveItems + fixed.stats().numInactivePages * Map::kPageSize);
+
+    // steady state: the threshold shrinks back to the lower bound
+    EXPECT_EQ(adaptiveThresholds[1], 4u);
+    adaptive.debug_stats();
+
+    // the settings are copied with the content
+    Map copy(adaptive);
+    EXPECT_EQ(copy.get_min_free_indices(), adaptive.get_min_free_indices());
+    copy.disable_adaptive_min_free_indices();
+    EXPECT_EQ(copy.get_min_free_indices(), 4u);
+}
+
+TEST(SlotMapTest, AdaptiveMinFreeIndicesDenseFirst)
+{
+    using Map = dod::slot_map32<int, 64, 16>;
+    Map slotMap;
+    slotMap.set_reuse_policy(dod::slot_map_reuse_policy::dense_first);
+    std::vector<Map::key> keys;
+    for (int i = 0; i < 1024; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+    for (size_t i = 0; i < keys.size(); i += 2)
+    {
+        slotMap.erase(keys[i]);
+    }
+    slotMap.debug_stats();
+
+    // shrinking the threshold moves the slots that rested long enough to the reuse stacks
+    slotMap.enable_adaptive_min_free_indices(2, 8);
+    EXPECT_EQ(slotMap.get_min_free_indices(), 8u);
+    slotMap.debug_stats();
+    size_t numReused = 0;
+    for (int i = 0; i < 512 - 8; i++)
+    {
+        Map::key k = slotMap.emplace(i);
+        numReused += (Map::key::toIndex(k) < 1024) ? 1 : 0;
+    }
+    EXPECT_EQ(numReused, size_t(512 - 8));
+    slotMap.debug_stats();
+}
+
+TEST(SlotMapTest, AdaptiveMinFreeIndicesLargeBounds)
+{
+    using Map = dod::slot_map32<int, 64, 0>;
+    Map slotMap;
+    std::vector<Map::key> keys(1024);
+    // every slot gets close to version overflow (the freed slots are reused right away)
+    for (int cycle = 0; cycle < 600; cycle++)
+    {
+        for (Map::key& k : keys)
+        {
+            k = slotMap.emplace(cycle);
+        }
+        for (const Map::key& k : keys)
+        {
+            slotMap.erase(k);
+        }
+    }
+    for (Map::key& k : keys)
+    {
+        k = slotMap.emplace(1);
+    }
+
+    // doubling a threshold above half of the size_type range reaches the upper bound instead of wrapping around
+    const Map::size_type maxValue = std::numeric_limits<Map::size_type>::max();
+    slotMap.enable_adaptive_min_free_indices(maxValue / 2 + 16, maxValue);
+    EXPECT_EQ(slotMap.get_min_free_indices(), maxValue / 2 + 16);
+    for (const Map::key& k : keys)
+    {
+        slotMap.erase(k);
+    }
+    EXPECT_EQ(slotMap.get_min_free_indices(), maxValue);
+}
@@ -0,0 +1,256 @@
+#include <dense_slot_map.h>
+#include <gtest/gtest.h>
+#include <slot_map.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+template <typename T, typename Layout = dod::slot_map_layout_split>
+using EpochMap = dod::slot_map<T, dod::slot_map_key32_epoch<T>, 16, 4, Layout>;
+
+// churns a few slots until their pages retire, reclaims the retired pages and repeats (stale keys are kept around)
+template <typename SLOT_MAP> void runReclaimWorkload(dod::slot_map_reuse_policy policy)
+{
+    using key = typename SLOT_MAP::key;
+    SLOT_MAP slotMap;
+    slotMap.set_reuse_policy(policy);
+    // the same workload without reclaiming
+    SLOT_MAP control;
+    control.set_reuse_policy(policy);
+
+    std::vector<key> liveKeys;
+    for (int i = 0; i < 40; i++)
+    {
+        liveKeys.emplace_back(slotMap.emplace(std::to_string(i)));
+        control.emplace(std::to_string(i));
+    }
+
+    std::vector<key> staleKeys;
+    size_t numReclaimed = 0;
+    for (int round = 0; round < 8; round++)
+    {
+        for (int step = 0; step < 30000; step++)
+        {
+            key k = slotMap.emplace("tmp");
+            slotMap.erase(k);
+            staleKeys.emplace_back(k);
+            control.erase(control.emplace("tmp"));
+        }
+        slotMap.debug_stats();
+
+        const auto numInactivePages = slotMap.stats().numInactivePages;
+        const auto reclaimed = slotMap.reclaim_inactive_pages();
+        EXPECT_EQ(slotMap.stats().numInactivePages, numInactivePages - reclaimed);
+        numReclaimed += reclaimed;
+        slotMap.debug_stats();
+
+        // keys issued before the reclaim never match the reclaimed slots (nor the slots reused after it)
+        for (int step = 0; step < 1000; step++)
+        {
+            slotMap.erase(slotMap.emplace("reuse"));
+        }
+        for (const key& k : staleKeys)
+        {
+            ASSERT_FALSE(slotMap.has_key(k));
+        }
+
+        ASSERT_EQ(slotMap.size(), liveKeys.size());
+        for (size_t i = 0; i < liveKeys.size(); i++)
+        {
+            ASSERT_NE(slotMap.get(liveKeys[i]), nullptr);
+            EXPECT_EQ(*slotMap.get(liveKeys[i]), std::to_string(i));
+        }
+    }
+
+    // the retired index ranges are reused: the index space grows much slower than without reclaiming (every index takes 4x the churn)
+    EXPECT_GT(numReclaimed, size_t(0));
+    EXPECT_GT(control.stats().numInactivePages, 0u);
+    EXPECT_LE(slotMap.stats().numPagesTotal * 2, control.stats().numPagesTotal);
+
+    SLOT_MAP copy(slotMap);
+    copy.debug_stats();
+    for (size_t i = 0; i < liveKeys.size(); i++)
+    {
+        ASSERT_NE(copy.get(liveKeys[i]), nullptr);
+        EXPECT_EQ(*copy.get(liveKeys[i]), std::to_string(i));
+    }
+    size_t numVisited = 0;
+    for (const auto& [k, v] : copy.items())
+    {
+        EXPECT_EQ(*slotMap.get(k), v.get());
+        numVisited++;
+    }
+    EXPECT_EQ(numVisited, liveKeys.size());
+}
+} // namespace
+
+TEST(SlotMapTest, ReclaimInactivePages)
+{
+    runReclaimWorkload<EpochMap<std::string>>(dod::slot_map_reuse_policy::fifo);
+    runReclaimWorkload<EpochMap<std::string>>(dod::slot_map_reuse_policy::dense_first);
+    runReclaimWorkload<EpochMap<std::string, dod::slot_map_layout_interleaved>>(dod::slot_map_reuse_policy::fifo);
+    runReclaimWorkload<EpochMap<std::string, dod::slot_map_layout_dense_meta>>(dod::slot_map_reuse_policy::fifo);
+    runReclaimWorkload<EpochMap<std::string, dod::slot_map_layout_contiguous>>(dod::slot_map_reuse_policy::dense_first);
+}
+
+TEST(SlotMapTest, ReclaimInactivePagesEpochs)
+{
+    using Key = dod::slot_map_key32_epoch<int>;
+    using Map = dod::slot_map<int, Key, 16, 0>;
+    Map slotMap;
+
+    // retires the first page (every version of every slot is handed out), returns all the keys
+    auto retireFirstPage = [&slotMap]() {
+        std::vector<Map::key> keys;
+        while (slotMap.stats().numInactivePages == 0)
+        {
+            Map::key k = slotMap.emplace(1);
+            keys.emplace_back(k);
+            slotMap.erase(k);
+        }
+        return keys;
+    };
+
+    std::vector<Map::key> staleKeys;
+    for (Key::version_t epoch = 0; epoch < Key::kMaxEpoch; epoch++)
+    {
+        std::vector<Map::key> keys = retireFirstPage();
+        // note: one key of the reclaimed page has been used by the previous round
+        EXPECT_EQ(keys.size(), size_t(16 * Key::kMaxVersion - (epoch == 0 ? 0 : 1)));
+        for (const Map::key& k : keys)
+        {
+            EXPECT_EQ(Key::toEpoch(k), epoch);
+            EXPECT_LT(Key::toIndex(k), 16u);
+        }
+        staleKeys.insert(staleKeys.end(), keys.begin(), keys.end());
+
+        EXPECT_EQ(slotMap.reclaim_inactive_pages(), 1u);
+        EXPECT_EQ(slotMap.stats().numInactivePages, 0u);
+
+        // the reclaimed slots are reused with the next epoch, the keys issued before the reclaim are rejected
+        Map::key k = slotMap.emplace(2);
+        EXPECT_EQ(Key::toEpoch(k), epoch + 1);
+        EXPECT_EQ(Key::toVersion(k), Key::kMinVersion);
+        EXPECT_EQ(*slotMap.get(k), 2);
+        for (const Map::key& stale : staleKeys)
+        {
+            ASSERT_FALSE(slotMap.has_key(stale));
+            ASSERT_EQ(slotMap.get(stale), nullptr);
+        }
+        // the stale keys of the reused slot don't erase the new value
+        for (const Map::key& stale : staleKeys)
+        {
+            if (Key::toIndex(stale) == Key::toIndex(k))
+            {
+                slotMap.erase(stale);
+            }
+        }
+        EXPECT_TRUE(slotMap.has_key(k));
+        slotMap.erase(k);
+        staleKeys.emplace_back(k);
+    }
+
+    // the epoch is exhausted: the page stays retired
+    retireFirstPage();
+    EXPECT_EQ(slotMap.reclaim_inactive_pages(), 0u);
+    EXPECT_EQ(slotMap.stats().numInactivePages, 1u);
+    Map::key k = slotMap.emplace(3);
+    EXPECT_GE(Key::toIndex(k), 16u);
+    EXPECT_EQ(Key::toEpoch(k), 0u);
+
+    // keys without epoch bits can't tell an old key from a new one: nothing is reclaimed
+    dod::slot_map32<int, 16, 0> noEpochs;
+    while (noEpochs.stats().numInactivePages == 0)
+    {
+        noEpochs.erase(noEpochs.emplace(1));
+    }
+    EXPECT_EQ(noEpochs.reclaim_inactive_pages(), 0u);
+    EXPECT_EQ(noEpochs.stats().numInactivePages, 1u);
+}
+
+TEST(SlotMapTest, ReclaimInactivePagesDense)
+{
+    using Map = dod::dense_slot_map<std::string, dod::slot_map_key32_epoch<std::string>, 16, 4>;
+    Map slotMap;
+    Map::key keep = slotMap.emplace("keep");
+    std::vector<Map::key> staleKeys;
+    for (int step = 0; step < 60000; step++)
+    {
+        Map::key k = slotMap.emplace("tmp");
+        staleKeys.emplace_back(k);
+        slotMap.erase(k);
+    }
+    ASSERT_GT(slotMap.stats().numInactivePages, 0u);
+    const auto numInactivePages = slotMap.stats().numInactivePages;
+    EXPECT_EQ(slotMap.reclaim_inactive_pages(), numInactivePages);
+    EXPECT_EQ(slotMap.stats().numInactivePages, 0u);
+    EXPECT_EQ(*slotMap.get(keep), "keep");
+    for (int step = 0; step < 1000; step++)
+    {
+        slotMap.erase(slotMap.emplace("reuse"));
+    }
+    Map::key k = slotMap.emplace("new");
+    EXPECT_EQ(*slotMap.get(k), "new");
+    EXPECT_EQ(slotMap.size(), 2u);
+    for (const Map::key& stale : staleKeys)
+    {
+        ASSERT_FALSE(slotMap.has_key(stale));
+    }
+}
+
+namespace
+{
+template <template <typename> class TKey> using IntKey = TKey<int>;
+}
+
+TEST(SlotMapTest, EpochKeys)
+{
+    // the default key types keep a single template parameter
+    static_assert(std::is_same_v<IntKey<dod::slot_map_key32>, dod::slot_map_key32<int>>);
+    static_assert(std::is_same_v<IntKey<dod::slot_map_key64>, dod::slot_map_key64<int>>);
+
+    // the epoch takes the tag bits, not the index bits
+    using Key64 = dod::slot_map_key64_epoch<int>;
+    static_assert(Key64::kMaxIndex == dod::slot_map_key64<int>::kMaxIndex);
+    static_assert(Key64::kMaxEpoch == 1023 && Key64::kMaxTag == 3);
+    static_assert((Key64::kIndexMask | Key64::kVersionMask | Key64::kEpochMask | Key64::kHandleTagMask) == ~0ull);
+    using Key32 = dod::slot_map_key32_epoch<int>;
+    static_assert(Key32::kMaxIndex == dod::slot_map_key32<int>::kMaxIndex);
+    static_assert(Key32::kMaxEpoch == 3 && Key32::kMaxTag == 0);
+    using Key32Tagged = dod::slot_map_key32_epoch<int, 1>;
+    static_assert(Key32Tagged::kMaxEpoch == 1 && Key32Tagged::kMaxTag == 1);
+
+    Key64 k64 = Key64::make(Key64::kMaxVersion, Key64::kMaxIndex, Key64::kMaxEpoch);
+    k64.set_tag(Key64::kMaxTag);
+    EXPECT_EQ(Key64::toIndex(k64), Key64::kMaxIndex);
+    EXPECT_EQ(Key64::toVersion(k64), Key64::kMaxVersion);
+    EXPECT_EQ(Key64::toEpoch(k64), Key64::kMaxEpoch);
+    EXPECT_EQ(k64.get_tag(), Key64::kMaxTag);
+    k64 = Key64::clearTagAndUpdateVersion(k64, 7);
+    EXPECT_EQ(k64.get_tag(), 0u);
+    EXPECT_EQ(Key64::toEpoch(k64), Key64::kMaxEpoch);
+    EXPECT_EQ(Key64::toVersion(k64), 7u);
+
+    Key32 k32 = Key32::make(Key32::kMaxVersion, Key32::kMaxIndex, Key32::kMaxEpoch);
+    k32.set_tag(0);
+    EXPECT_EQ(k32.get_tag(), 0u);
+    EXPECT_EQ(Key32::toIndex(k32), Key32::kMaxIndex);
+    EXPECT_EQ(Key32::toVersion(k32), Key32::kMaxVersion);
+    EXPECT_EQ(Key32::toEpoch(k32), Key32::kMaxEpoch);
+
+    Key32Tagged t32 = Key32Tagged::make(1, 5, 1);
+    t32.set_tag(1);
+    EXPECT_EQ(t32.get_tag(), 1u);
+    EXPECT_EQ(Key32Tagged::toEpoch(t32), 1u);
+    EXPECT_EQ(Key32Tagged::toIndex(t32), 5u);
+
+    // reclaiming works with the 64-bit epoch keys as well
+    dod::slot_map<int, Key64, 16, 0> slotMap;
+    EXPECT_EQ(slotMap.reclaim_inactive_pages(), 0u);
+    Key64 k = slotMap.emplace(1);
+    EXPECT_EQ(Key64::toEpoch(k), 0u);
+    EXPECT_EQ(std::hash<Key64>{}(k), k.hash());
+    EXPECT_EQ(*slotMap.get(k), 1);
+}
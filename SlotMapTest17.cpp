@@ -0,0 +1,251 @@
+#include <dense_slot_map.h>
+#include <gtest/gtest.h>
+#include <slot_map.h>
+#include <slot_map_page_pool.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+template <typename SLOT_MAP> void runReserveShrinkWorkload()
+{
+    using key = typename SLOT_MAP::key;
+    constexpr typename SLOT_MAP::size_type kPageSize = SLOT_MAP::kPageSize;
+    SLOT_MAP slotMap;
+
+    // empty map
+    slotMap.reserve(kPageSize * 3 + 1);
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 4u);
+    EXPECT_EQ(slotMap.stats().numActivePages, 4u);
+    slotMap.debug_stats();
+    slotMap.shrink_to_fit();
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 0u);
+    slotMap.debug_stats();
+
+    // the reserved pages are used in order
+    slotMap.reserve(kPageSize * 3);
+    std::vector<key> keys;
+    for (typename SLOT_MAP::size_type i = 0; i < kPageSize * 3; i++)
+    {
+        keys.emplace_back(slotMap.emplace(std::to_string(i)));
+        ASSERT_EQ(SLOT_MAP::key::toIndex(keys.back()), i);
+    }
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 3u);
+    slotMap.debug_stats();
+
+    // the trailing pages hold tombstones only
+    for (size_t i = kPageSize + 1; i < keys.size(); i++)
+    {
+        slotMap.erase(keys[i]);
+    }
+    slotMap.reserve(kPageSize * 4);
+    slotMap.debug_stats();
+    slotMap.shrink_to_fit();
+    auto stats = slotMap.debug_stats();
+    EXPECT_EQ(stats.numPagesTotal, 2u);
+    EXPECT_EQ(stats.numActivePages, 2u);
+    EXPECT_EQ(stats.numInactivePages, 0u);
+    EXPECT_EQ(slotMap.size(), kPageSize + 1);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        if (i <= kPageSize)
+        {
+            ASSERT_NE(slotMap.get(keys[i]), nullptr);
+            EXPECT_EQ(*slotMap.get(keys[i]), std::to_string(i));
+        }
+        else
+        {
+            EXPECT_FALSE(slotMap.has_key(keys[i]));
+        }
+    }
+
+    // the released range is created again: the versions continue above the ones handed out before the shrink
+    std::vector<key> newKeys;
+    for (typename SLOT_MAP::size_type i = 0; i < kPageSize * 3; i++)
+    {
+        newKeys.emplace_back(slotMap.emplace("new"));
+    }
+    slotMap.debug_stats();
+    for (size_t i = kPageSize + 1; i < keys.size(); i++)
+    {
+        EXPECT_FALSE(slotMap.has_key(keys[i]));
+    }
+    for (const key& k : newKeys)
+    {
+        ASSERT_NE(slotMap.get(k), nullptr);
+        EXPECT_EQ(*slotMap.get(k), "new");
+        const auto index = SLOT_MAP::key::toIndex(k);
+        if (index > kPageSize && index < keys.size())
+        {
+            EXPECT_GT(SLOT_MAP::key::toVersion(k), SLOT_MAP::key::toVersion(keys[index]));
+        }
+    }
+
+    // the same again with stale keys of every generation
+    for (const key& k : newKeys)
+    {
+        slotMap.erase(k);
+    }
+    slotMap.shrink_to_fit();
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 2u);
+    for (typename SLOT_MAP::size_type i = 0; i < kPageSize * 3; i++)
+    {
+        slotMap.emplace("again");
+    }
+    for (size_t i = kPageSize + 1; i < keys.size(); i++)
+    {
+        EXPECT_FALSE(slotMap.has_key(keys[i]));
+    }
+    for (const key& k : newKeys)
+    {
+        EXPECT_FALSE(slotMap.has_key(k));
+    }
+    slotMap.debug_stats();
+
+    SLOT_MAP copy(slotMap);
+    copy.debug_stats();
+    slotMap.clear();
+    slotMap.shrink_to_fit();
+    EXPECT_EQ(slotMap.debug_stats().numActivePages, 0u);
+    key k = slotMap.emplace("last");
+    EXPECT_EQ(*slotMap.get(k), "last");
+    slotMap.debug_stats();
+}
+} // namespace
+
+TEST(SlotMapTest, ReserveAndShrinkToFit)
+{
+    runReserveShrinkWorkload<dod::slot_map64<std::string, 64, 16>>();
+    runReserveShrinkWorkload<dod::slot_map32<std::string, 16, 4, dod::slot_map_layout_interleaved>>();
+    runReserveShrinkWorkload<dod::slot_map64<std::string, 64, 16, dod::slot_map_layout_dense_meta>>();
+    runReserveShrinkWorkload<dod::slot_map64<std::string, 64, 16, dod::slot_map_layout_contiguous>>();
+}
+
+TEST(SlotMapTest, ReserveNoAllocations)
+{
+    dod::slot_map_page_pool pool;
+    dod::slot_map64<int, 256, 16> slotMap;
+    slotMap.set_page_allocator(&pool);
+
+    slotMap.reserve(1000);
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(4));
+    std::vector<dod::slot_map64<int, 256, 16>::key> keys;
+    for (int i = 0; i < 1000; i++)
+    {
+        keys.emplace_back(slotMap.emplace(i));
+    }
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(4));
+
+    // erased slots are counted only if they would be reused
+    for (size_t i = 0; i < 500; i++)
+    {
+        slotMap.erase(keys[i]);
+    }
+    slotMap.reserve(slotMap.size() + 500 - 16);
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 4u);
+    slotMap.reserve(slotMap.size() + 500 - 16 + 24 + 1);
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 5u);
+    for (int i = 0; i < 500 - 16 + 24 + 1; i++)
+    {
+        slotMap.emplace(i);
+    }
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 5u);
+    EXPECT_EQ(pool.stats().numSystemAllocations, uint64_t(5));
+    slotMap.debug_stats();
+}
+
+TEST(SlotMapTest, DenseMetaTableGrowth)
+{
+    using Map = dod::slot_map<int, dod::slot_map_key64<int>, 64, 0, dod::slot_map_layout_dense_meta>;
+    constexpr int kNumItems = 64 * 1024;
+
+    // the version table doubles its capacity: a logarithmic number of reallocations (copies) for a growing map
+    Map slotMap;
+    size_t numGrowths = 0;
+    size_t tableBytes = 0;
+    for (int i = 0; i < kNumItems; i++)
+    {
+        slotMap.emplace(i);
+        const size_t bytes = slotMap.memory_stats().metaTableBytes;
+        if (bytes != tableBytes)
+        {
+            EXPECT_GE(bytes, tableBytes * 2);
+            tableBytes = bytes;
+            numGrowths++;
+        }
+    }
+    // 1024 pages: 1, 2, 4, ... 1024 pages
+    EXPECT_LE(numGrowths, size_t(11));
+
+    // reserve sizes the table up front: no reallocation on the emplace path
+    Map reserved;
+    reserved.reserve(kNumItems);
+    const size_t reservedBytes = reserved.memory_stats().metaTableBytes;
+    EXPECT_GE(reservedBytes, size_t(kNumItems) * sizeof(Map::version_t));
+    for (int i = 0; i < kNumItems; i++)
+    {
+        reserved.emplace(i);
+    }
+    EXPECT_EQ(reserved.memory_stats().metaTableBytes, reservedBytes);
+}
+
+TEST(SlotMapTest, DenseReserveAndShrinkToFit)
+{
+    dod::dense_slot_map64<std::string, 64, 16> slotMap;
+    slotMap.reserve(200);
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 4u);
+    std::vector<dod::dense_slot_map64<std::string, 64, 16>::key> keys;
+    for (int i = 0; i < 200; i++)
+    {
+        keys.emplace_back(slotMap.emplace(std::to_string(i)));
+    }
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 4u);
+    for (size_t i = 64; i < keys.size(); i++)
+    {
+        slotMap.erase(keys[i]);
+    }
+    slotMap.shrink_to_fit();
+    EXPECT_EQ(slotMap.stats().numActivePages, 1u);
+    for (size_t i = 0; i < 64; i++)
+    {
+        EXPECT_EQ(*slotMap.get(keys[i]), std::to_string(i));
+    }
+}
+
+TEST(SlotMapTest, ShrinkToFitRetiredPages)
+{
+    using Key = dod::slot_map_key32_epoch<int>;
+    using Map = dod::slot_map<int, Key, 16, 0>;
+    Map slotMap;
+    std::vector<Map::key> staleKeys;
+    while (slotMap.stats().numInactivePages == 0)
+    {
+        Map::key k = slotMap.emplace(1);
+        staleKeys.emplace_back(k);
+        slotMap.erase(k);
+    }
+
+    // the retired page is released, its range comes back with the next page epoch
+    slotMap.shrink_to_fit();
+    EXPECT_EQ(slotMap.stats().numPagesTotal, 0u);
+    Map::key k = slotMap.emplace(2);
+    EXPECT_EQ(Key::toIndex(k), 0u);
+    EXPECT_EQ(Key::toEpoch(k), 1u);
+    EXPECT_EQ(*slotMap.get(k), 2);
+    for (const Map::key& stale : staleKeys)
+    {
+        ASSERT_FALSE(slotMap.has_key(stale));
+    }
+
+    // keys without epoch bits: the retired page stays
+    using NoEpochsMap = dod::slot_map32<int, 16, 0>;
+    NoEpochsMap noEpochs;
+    while (noEpochs.stats().numInactivePages == 0)
+    {
+        noEpochs.erase(noEpochs.emplace(1));
+    }
+    noEpochs.shrink_to_fit();
+    EXPECT_EQ(noEpochs.stats().numPagesTotal, 1u);
+    EXPECT_EQ(noEpochs.stats().numInactivePages, 1u);
+    EXPECT_GE(NoEpochsMap::key::toIndex(noEpochs.emplace(3)), 16u);
+}
@@ -0,0 +1,374 @@
+#include "SlotMapReplay.h"
+#include <cmath>
+#include <cstring>
+
+/*
+  Recommends PAGESIZE and MINFREEINDICES for a given workload.
+
+  Replays a recorded (or synthetic) workload across a grid of slot_map configurations, reports throughput, peak memory,
+  deactivated-slot rate and projected time to index exhaustion (slot_map_key32 only, see below) and prints the best configuration
+  for the chosen objective.
+
+  Usage:
+    SlotMapTune <trace file> [--objective=<throughput|memory|longevity|balanced>] [--key=<32|64|all>] [--rate=<N>] [--csv]
+    SlotMapTune --synthetic=<steady|bursty> [--ops=<N>] [--live=<N>] [...]
+
+  Objectives:
+    throughput - the lowest ns/op
+    memory     - the lowest peak memory footprint
+    longevity  - the longest projected time to index exhaustion (then the lowest ns/op)
+    balanced   - the lowest (ns/op / best ns/op) + (peak memory / best peak memory)
+
+  Index exhaustion: every deactivated slot (version overflow) is retired forever, so the index space used by the map keeps growing
+  at the rate of (deactivated slots / emplaces). slot_map_key32 has only 1M indices, the projection extrapolates this rate from the
+  replayed workload and converts it into time using --rate (emplaces per second in the real application, default 10000).
+  Configurations that exhaust the index space during the replay are never recommended.
+
+  Note: build in Release, Debug numbers are meaningless.
+*/
+
+namespace
+{
+
+enum class Objective
+{
+    Throughput,
+    Memory,
+    Longevity,
+    Balanced,
+};
+
+struct Options
+{
+    const char* tracePath = nullptr;
+    const char* synthetic = nullptr;
+    size_t numOps = 4000000;
+    uint32_t liveSetSize = 100000;
+    Objective objective = Objective::Balanced;
+    int keyBits = 0; // 0 = all
+    double emplacesPerSecond = 10000.0;
+    bool csv = false;
+};
+
+struct Row
+{
+    std::string config;
+    int keyBits = 0;
+    size_t pageSize = 0;
+    size_t minFreeIndices = 0;
+    replay::Result result;
+
+    // deactivated (retired) slots per one million emplaces
+    double deactivatedPerMillion() const
+    {
+        return result.numEmplaces ? double(result.numDeactivatedSlots) * 1000000.0 / double(result.numEmplaces) : 0.0;
+    }
+
+    // projected number of emplaces until the index space is exhausted (infinity = never)
+    double emplacesToExhaustion() const
+    {
+        if (!result.completed)
+        {
+            return double(result.numEmplaces);
+        }
+        if (keyBits != 32 || result.numDeactivatedSlots == 0 || result.numEmplaces == 0)
+        {
+            return INFINITY;
+        }
+        double retiredPerEmplace = double(result.numDeactivatedSlots) / double(result.numEmplaces);
+        double remainingIndices = double(result.maxIndex + 1) - double(result.indexSpaceUsed);
+        return double(result.numEmplaces) + std::max(remainingIndices, 0.0) / retiredPerEmplace;
+    }
+};
+
+const char* objectiveName(Objective objective)
+{
+    switch (objective)
+    {
+    case Objective::Throughput:
+        return "throughput";
+    case Objective::Memory:
+        return "memory";
+    case Objective::Longevity:
+        return "longevity";
+    case Objective::Balanced:
+        return "balanced";
+    }
+    return "unknown";
+}
+
+bool parseObjective(const char* str, Objective& objective)
+{
+    const Objective all[] = {Objective::Throughput, Objective::Memory, Objective::Longevity, Objective::Balanced};
+    for (Objective o : all)
+    {
+        if (strcmp(str, objectiveName(o)) == 0)
+        {
+            objective = o;
+            return true;
+        }
+    }
+    return false;
+}
+
+void formatExhaustion(char* buf, size_t bufSize, const Row& row, const Options& opts)
+{
+    if (row.keyBits != 32)
+    {
+        snprintf(buf, bufSize, "-");
+        return;
+    }
+    if (!row.result.completed)
+    {
+        snprintf(buf, bufSize, "during replay");
+        return;
+    }
+    double emplaces = row.emplacesToExhaustion();
+    if (std::isinf(emplaces))
+    {
+        snprintf(buf, bufSize, "never");
+        return;
+    }
+    double hours = emplaces / opts.emplacesPerSecond / 3600.0;
+    snprintf(buf, bufSize, "%.3g h", hours);
+}
+
+void printHeader(const Options& opts)
+{
+    if (opts.csv)
+    {
+        printf("workload,config,completed,ns_per_op,mops_per_sec,peak_mb,deactivated_per_million_emplaces,emplaces_to_exhaustion\n");
+    }
+    else
+    {
+        printf("%-32s %10s %10s %10s %14s %16s\n", "config", "ns/op", "Mops/s", "peak (MB)", "deactivated/1M", "exhaustion (key32)");
+    }
+}
+
+void printRow(const Options& opts, const replay::Workload& workload, const Row& row)
+{
+    const replay::Result& r = row.result;
+    double peakMb = double(r.peakBytes) / (1024.0 * 1024.0);
+    double mops = r.nsPerOp() > 0.0 ? 1000.0 / r.nsPerOp() : 0.0;
+    if (opts.csv)
+    {
+        printf("%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%.0f\n", workload.name.c_str(), row.config.c_str(), r.completed ? 1 : 0, r.nsPerOp(), mops, peakMb,
+               row.deactivatedPerMillion(), row.emplacesToExhaustion());
+    }
+    else
+    {
+        char exhaustion[64];
+        formatExhaustion(exhaustion, sizeof(exhaustion), row, opts);
+        printf("%-32s %10.2f %10.2f %10.2f %14.1f %16s\n", row.config.c_str(), r.nsPerOp(), mops, peakMb, row.deactivatedPerMillion(),
+               exhaustion);
+    }
+    fflush(stdout);
+}
+
+template <typename MAP, typename VALUE> void run(const Options& opts, const replay::Workload& workload, std::vector<Row>& rows)
+{
+    Row row;
+    row.config = replay::configName<MAP>(sizeof(VALUE));
+    row.keyBits = int(sizeof(typename MAP::key) * 8);
+    row.pageSize = MAP::kPageSize;
+    row.minFreeIndices = MAP::kMinFreeIndices;
+    if (opts.keyBits != 0 && opts.keyBits != row.keyBits)
+    {
+        return;
+    }
+    row.result = replay::replayWorkload<MAP, VALUE>(workload);
+    printRow(opts, workload, row);
+    rows.push_back(row);
+}
+
+template <typename VALUE, size_t PAGESIZE> void runMinFreeIndices(const Options& opts, const replay::Workload& workload, std::vector<Row>& rows)
+{
+    run<dod::slot_map32<VALUE, PAGESIZE, 16>, VALUE>(opts, workload, rows);
+    run<dod::slot_map32<VALUE, PAGESIZE, 64>, VALUE>(opts, workload, rows);
+    run<dod::slot_map32<VALUE, PAGESIZE, 256>, VALUE>(opts, workload, rows);
+    run<dod::slot_map32<VALUE, PAGESIZE, 1024>, VALUE>(opts, workload, rows);
+    run<dod::slot_map32<VALUE, PAGESIZE, 4096>, VALUE>(opts, workload, rows);
+    run<dod::slot_map64<VALUE, PAGESIZE, 16>, VALUE>(opts, workload, rows);
+    run<dod::slot_map64<VALUE, PAGESIZE, 64>, VALUE>(opts, workload, rows);
+    run<dod::slot_map64<VALUE, PAGESIZE, 256>, VALUE>(opts, workload, rows);
+    run<dod::slot_map64<VALUE, PAGESIZE, 1024>, VALUE>(opts, workload, rows);
+    run<dod::slot_map64<VALUE, PAGESIZE, 4096>, VALUE>(opts, workload, rows);
+}
+
+template <typename VALUE> void runGrid(const Options& opts, const replay::Workload& workload, std::vector<Row>& rows)
+{
+    runMinFreeIndices<VALUE, 256>(opts, workload, rows);
+    runMinFreeIndices<VALUE, 1024>(opts, workload, rows);
+    runMinFreeIndices<VALUE, 4096>(opts, workload, rows);
+    runMinFreeIndices<VALUE, 16384>(opts, workload, rows);
+}
+
+// returns true if `a` is a better choice than `b` for the given objective
+bool isBetter(const Row& a, const Row& b, Objective objective, double bestNs, double bestPeak)
+{
+    const replay::Result& ra = a.result;
+    const replay::Result& rb = b.result;
+    switch (objective)
+    {
+    case Objective::Throughput:
+        return ra.nsPerOp() < rb.nsPerOp();
+    case Objective::Memory:
+        return (ra.peakBytes != rb.peakBytes) ? (ra.peakBytes < rb.peakBytes) : (ra.nsPerOp() < rb.nsPerOp());
+    case Objective::Longevity:
+    {
+        double ea = a.emplacesToExhaustion();
+        double eb = b.emplacesToExhaustion();
+        return (ea != eb) ? (ea > eb) : (ra.nsPerOp() < rb.nsPerOp());
+    }
+    case Objective::Balanced:
+    {
+        double sa = ra.nsPerOp() / bestNs + double(ra.peakBytes) / bestPeak;
+        double sb = rb.nsPerOp() / bestNs + double(rb.peakBytes) / bestPeak;
+        return sa < sb;
+    }
+    }
+    return false;
+}
+
+const Row* findBest(const std::vector<Row>& rows, Objective objective)
+{
+    double bestNs = INFINITY;
+    double bestPeak = INFINITY;
+    for (const Row& row : rows)
+    {
+        if (row.result.completed)
+        {
+            bestNs = std::min(bestNs, row.result.nsPerOp());
+            bestPeak = std::min(bestPeak, double(row.result.peakBytes));
+        }
+    }
+    bestNs = std::max(bestNs, 1e-9);
+    bestPeak = std::max(bestPeak, 1.0);
+
+    const Row* best = nullptr;
+    for (const Row& row : rows)
+    {
+        if (!row.result.completed)
+        {
+            continue;
+        }
+        if (best == nullptr || isBetter(row, *best, objective, bestNs, bestPeak))
+        {
+            best = &row;
+        }
+    }
+    return best;
+}
+
+bool parseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--synthetic=", 12) == 0)
+        {
+            opts.synthetic = arg + 12;
+        }
+        else if (strncmp(arg, "--ops=", 6) == 0)
+        {
+            opts.numOps = size_t(strtoull(arg + 6, nullptr, 10));
+        }
+        else if (strncmp(arg, "--live=", 7) == 0)
+        {
+            opts.liveSetSize = uint32_t(strtoul(arg + 7, nullptr, 10));
+        }
+        else if (strncmp(arg, "--objective=", 12) == 0)
+        {
+            if (!parseObjective(arg + 12, opts.objective))
+            {
+                return false;
+            }
+        }
+        else if (strncmp(arg, "--key=", 6) == 0)
+        {
+            opts.keyBits = (strcmp(arg + 6, "all") == 0) ? 0 : atoi(arg + 6);
+            if (opts.keyBits != 0 && opts.keyBits != 32 && opts.keyBits != 64)
+            {
+                return false;
+            }
+        }
+        else if (strncmp(arg, "--rate=", 7) == 0)
+        {
+            opts.emplacesPerSecond = strtod(arg + 7, nullptr);
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            opts.csv = true;
+        }
+        else if (arg[0] != '-' && opts.tracePath == nullptr)
+        {
+            opts.tracePath = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return (opts.tracePath != nullptr) != (opts.synthetic != nullptr) && opts.liveSetSize > 0 && opts.emplacesPerSecond > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parseArgs(argc, argv, opts))
+    {
+        printf("Usage:\n");
+        printf("  %s <trace file> [--objective=<throughput|memory|longevity|balanced>] [--key=<32|64|all>] [--rate=<N>] [--csv]\n", argv[0]);
+        printf("  %s --synthetic=<steady|bursty> [--ops=<N>] [--live=<N>] [...]\n", argv[0]);
+        return 1;
+    }
+
+    replay::Workload workload;
+    if (opts.tracePath)
+    {
+        if (!replay::loadWorkload(opts.tracePath, workload))
+        {
+            printf("Can't load trace '%s'\n", opts.tracePath);
+            return 1;
+        }
+    }
+    else
+    {
+        workload = replay::makeSyntheticWorkload(opts.synthetic, opts.numOps, opts.liveSetSize, 0x5107ab);
+    }
+
+    if (!opts.csv)
+    {
+        printf("workload: %s, %zu ops, value size: %u bytes\n\n", workload.name.c_str(), workload.ops.size(), workload.valueSize);
+    }
+    printHeader(opts);
+
+    std::vector<Row> rows;
+    replay::dispatchPayload(workload.valueSize, [&](auto* payload) {
+        using VALUE = typename std::remove_pointer<decltype(payload)>::type;
+        runGrid<VALUE>(opts, workload, rows);
+    });
+
+    const Row* best = findBest(rows, opts.objective);
+    if (opts.csv)
+    {
+        // keep the output machine readable
+        return best ? 0 : 1;
+    }
+
+    printf("\n");
+    if (best == nullptr)
+    {
+        printf("No configuration has completed the workload without exhausting the index space, use slot_map_key64\n");
+        return 1;
+    }
+    char exhaustion[64];
+    formatExhaustion(exhaustion, sizeof(exhaustion), *best, opts);
+    printf("Best configuration (objective: %s): %s\n", objectiveName(opts.objective), best->config.c_str());
+    printf("  dod::slot_map%d<T, %zu, %zu>\n", best->keyBits, best->pageSize, best->minFreeIndices);
+    printf("  %.2f ns/op, %.2f MB peak, %.1f deactivated slots per 1M emplaces, key32 index exhaustion: %s\n", best->result.nsPerOp(),
+           double(best->result.peakBytes) / (1024.0 * 1024.0), best->deactivatedPerMillion(), exhaustion);
+    return 0;
+}
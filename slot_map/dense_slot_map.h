@@ -0,0 +1,247 @@
+#pragma once
+
+#include "slot_map.h"
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace dod
+{
+
+/*
+  Dense slot map
+
+  Values are kept contiguous in a single array (no gaps, no tombstones), erase moves the last value into the erased position
+  (swap-and-pop). An indirection table maps slot index -> dense position.
+
+  Keys are the same slot_map_key64/slot_map_key32 types and have the same semantics (versions, free indices, version overflow handling)
+  as dod::slot_map keys, the indirection table is a slot_map<size_type> (interleaved layout, a lookup touches a single cache line).
+
+  Trade-off: no pointer stability (values move on erase and on growth) in exchange for perfectly linear iteration.
+
+  Usage example:
+  ```
+  dense_slot_map<Particle> particles;
+  auto p = particles.emplace(...);
+  particles.erase(p);
+
+  // gap-free iteration
+  for (Particle& particle : particles)
+  {
+      ...
+  }
+  ```
+*/
+template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64> class dense_slot_map
+{
+  public:
+    using key = TKeyType;
+    using version_t = typename TKeyType::version_t;
+    using index_t = typename TKeyType::index_t;
+    using tag_t = typename TKeyType::tag_t;
+    using size_type = uint32_t;
+
+  private:
+    // slot index -> dense position
+    using Slots = slot_map<size_type, TKeyType, PAGESIZE, MINFREEINDICES, slot_map_layout_interleaved>;
+
+  public:
+    using Stats = typename Slots::Stats;
+
+    static inline constexpr size_type kPageSize = Slots::kPageSize;
+    static inline constexpr size_type kMinFreeIndices = Slots::kMinFreeIndices;
+
+    /*
+      Constructs element in-place and returns a unique key that can be used to access this value.
+      Note: could invalidate pointers to the values (the values array could grow)
+    */
+    template <class... Args> key emplace(Args&&... args)
+    {
+        size_type pos = static_cast<size_type>(values.size());
+        // note: grow denseKeys up front so that nothing can throw once the slot is taken
+        if (denseKeys.size() == denseKeys.capacity())
+        {
+            denseKeys.reserve(std::max(denseKeys.capacity() * 2, size_t(16)));
+        }
+        values.emplace_back(std::forward<Args>(args)...);
+        // if the slot allocation throws, the new value is removed again
+        ValueGuard valueGuard{values};
+        key k = slots.emplace(pos);
+        valueGuard.dismissed = true;
+        denseKeys.emplace_back(k);
+        SLOT_MAP_ASSERT(values.size() == denseKeys.size());
+        return k;
+    }
+
+    /*
+      Returns true if the slot map contains a specific key
+    */
+    bool has_key(key k) const noexcept { return slots.has_key(k); }
+
+    /*
+      If key exists returns a pointer to the value corresponding to the given key or returns null elsewere.
+    */
+    const T* get(key k) const noexcept
+    {
+        const size_type* pos = slots.get(k);
+        if (pos == nullptr)
+        {
+            return nullptr;
+        }
+        SLOT_MAP_ASSERT(*pos < values.size());
+        return &values[*pos];
+    }
+
+    T* get(key k) noexcept { return const_cast<T*>(std::as_const(*this).get(k)); }
+
+    /*
+      Removes element (if such key exists) from the slot map.
+      The last value is moved into the position of the removed value.
+    */
+    void erase(key k)
+    {
+        const size_type* pos = slots.get(k);
+        if (pos == nullptr)
+        {
+            return;
+        }
+        removeAt(*pos);
+        slots.erase(k);
+    }
+
+    /*
+      Removes element (if such key exists) from the slot map, returning the value at the key if the key was not previously removed.
+    */
+    std::optional<T> pop(key k)
+    {
+        const size_type* pos = slots.get(k);
+        if (pos == nullptr)
+        {
+            return {};
+        }
+        T res(std::move(values[*pos]));
+        removeAt(*pos);
+        slots.erase(k);
+        return res;
+    }
+
+    /*
+      Clears the slot map but keeps the allocated memory for reuse.
+      Automatically increases version for all the removed elements (the same as calling "erase()" for all existing elements)
+    */
+    void clear()
+    {
+        values.clear();
+        denseKeys.clear();
+        slots.clear();
+    }
+
+    /*
+      Clears the slot map and releases any allocated memory (see slot_map::reset)
+    */
+    void reset()
+    {
+        std::vector<T, stl::Allocator<T>> tmpValues;
+        values.swap(tmpValues);
+        std::vector<key, stl::Allocator<key>> tmpKeys;
+        denseKeys.swap(tmpKeys);
+        slots.reset();
+    }
+
+    /*
+      Pre-allocates memory for `numElements` values (see slot_map::reserve)
+    */
+    void reserve(size_type numElements)
+    {
+        values.reserve(numElements);
+        denseKeys.reserve(numElements);
+        slots.reserve(numElements);
+    }
+
+    /*
+      Releases unused memory, live keys stay valid (see slot_map::shrink_to_fit)
+    */
+    void shrink_to_fit()
+    {
+        values.shrink_to_fit();
+        denseKeys.shrink_to_fit();
+        slots.shrink_to_fit();
+    }
+
+    /*
+      Makes the index space of the retired pages usable again (see slot_map::reclaim_inactive_pages)
+      Note: requires keys with page epoch bits (slot_map_key32_epoch / slot_map_key64_epoch), does nothing otherwise.
+    */
+    size_type reclaim_inactive_pages() { return slots.reclaim_inactive_pages(); }
+
+    bool empty() const noexcept { return values.empty(); }
+    size_type size() const noexcept { return static_cast<size_type>(values.size()); }
+    Stats stats() const noexcept { return slots.stats(); }
+
+    /*
+      Exchanges the content of the slot map by the content of another slot map object of the same type.
+    */
+    void swap(dense_slot_map& other) noexcept
+    {
+        values.swap(other.values);
+        denseKeys.swap(other.denseKeys);
+        slots.swap(other.slots);
+    }
+
+    /*
+      Dense values and their keys (keys()[i] is the key of data()[i])
+    */
+    T* data() noexcept { return values.data(); }
+    const T* data() const noexcept { return values.data(); }
+    const key* keys() const noexcept { return denseKeys.data(); }
+
+    T* begin() noexcept { return values.data(); }
+    T* end() noexcept { return values.data() + values.size(); }
+    const T* begin() const noexcept { return values.data(); }
+    const T* end() const noexcept { return values.data() + values.size(); }
+
+  private:
+    // removes the last value unless dismissed
+    struct ValueGuard
+    {
+        std::vector<T, stl::Allocator<T>>& values;
+        bool dismissed = false;
+
+        ~ValueGuard()
+        {
+            if (!dismissed)
+            {
+                values.pop_back();
+            }
+        }
+    };
+
+    // swap-and-pop (the slot of the removed value is erased by the caller)
+    void removeAt(size_type pos)
+    {
+        SLOT_MAP_ASSERT(pos < values.size());
+        size_type lastPos = static_cast<size_type>(values.size() - 1);
+        if (pos != lastPos)
+        {
+            values[pos] = std::move(values[lastPos]);
+            denseKeys[pos] = denseKeys[lastPos];
+            size_type* movedPos = slots.get(denseKeys[pos]);
+            SLOT_MAP_ASSERT(movedPos && *movedPos == lastPos);
+            *movedPos = pos;
+        }
+        values.pop_back();
+        denseKeys.pop_back();
+    }
+
+    std::vector<T, stl::Allocator<T>> values;
+    std::vector<key, stl::Allocator<key>> denseKeys;
+    Slots slots;
+};
+
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
+using dense_slot_map32 = dense_slot_map<T, dod::slot_map_key32<T>, PAGESIZE, MINFREEINDICES>;
+
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
+using dense_slot_map64 = dense_slot_map<T, dod::slot_map_key64<T>, PAGESIZE, MINFREEINDICES>;
+
+} // namespace dod
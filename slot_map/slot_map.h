@@ -1,8 +1,9 @@
 #pragma once
 
 #include <cstring>
-#include <deque>
 #include <functional>
+#include <limits>
+#include <memory_resource>
 #include <optional>
 #include <stdint.h>
 #include <vector>
@@ -12,6 +13,10 @@
 #include <inttypes.h>
 #define PRIslotkey PRIu64
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 // TODO (detailed desc): you could override memory allocator by defining SLOT_MAP_ALLOC/SLOT_MAP_FREE macroses
 #if !defined(SLOT_MAP_ALLOC) || !defined(SLOT_MAP_FREE)
 
@@ -38,9 +43,39 @@
 #define SLOT_MAP_ASSERT(expression) assert(expression)
 #endif
 
+// You could enable hot-path instrumentation counters by defining SLOT_MAP_INSTRUMENT (see slot_map::instrument_counters())
+// Note: When SLOT_MAP_INSTRUMENT is not defined the counters (and all the code that updates them) are compiled out.
+// Note: the counters are relaxed atomics (const get/has_key could be called from several threads at once).
+#if defined(SLOT_MAP_INSTRUMENT)
+#include <atomic>
+#include <initializer_list>
+#include <stdio.h>
+#include <string>
+#define SLOT_MAP_INSTRUMENT_INC(counter) (instrument.counter.fetch_add(1, std::memory_order_relaxed))
+#define SLOT_MAP_INSTRUMENT_ADD(counter, value) (instrument.counter.fetch_add(static_cast<uint64_t>(value), std::memory_order_relaxed))
+// note: only called from non-const (single writer) paths
+#define SLOT_MAP_INSTRUMENT_MAX(counter, value)                                                                                            \
+    (instrument.counter.store(std::max(instrument.counter.load(std::memory_order_relaxed), static_cast<uint64_t>(value)),                  \
+                              std::memory_order_relaxed))
+#else
+#define SLOT_MAP_INSTRUMENT_INC(counter) ((void)0)
+#define SLOT_MAP_INSTRUMENT_ADD(counter, value) ((void)0)
+#define SLOT_MAP_INSTRUMENT_MAX(counter, value) ((void)0)
+#endif
+
+// You could record workload traces by defining SLOT_MAP_TRACE (see slot_map::set_trace_recorder() and slot_map_trace.h)
+// Note: When SLOT_MAP_TRACE is not defined the recording code is compiled out.
+#if defined(SLOT_MAP_TRACE)
+#include "slot_map_trace.h"
+#define SLOT_MAP_TRACE_RECORD(op, k) (traceRecorder ? traceRecorder->record(dod::slot_map_trace_op::op, static_cast<uint64_t>(k)) : (void)0)
+#else
+#define SLOT_MAP_TRACE_RECORD(op, k) ((void)0)
+#endif
+
 namespace stl
 {
 // STL compatible allocator
+// Uses SLOT_MAP_ALLOC/SLOT_MAP_FREE or (if set) a std::pmr::memory_resource. The resource propagates on move/swap but not on copy assignment.
 // Note: some platforms (macOS) does not support alignments smaller than `alignof(void*)`
 template <class T, size_t Alignment = std::max(alignof(T), alignof(void*))> struct Allocator
 {
@@ -53,15 +88,35 @@ template <class T, size_t Alignment = std::max(alignof(T), alignof(void*))> stru
     using size_type = size_t;
     using difference_type = ptrdiff_t;
 
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
     template <class U> struct rebind
     {
         using other = Allocator<U, Alignment>;
     };
 
-    Allocator() noexcept {}
-    Allocator(const Allocator& /*other*/) noexcept {}
+    Allocator() noexcept
+        : memoryResource(nullptr)
+    {
+    }
+    // nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE
+    explicit Allocator(std::pmr::memory_resource* resource) noexcept
+        : memoryResource(resource)
+    {
+    }
+    Allocator(const Allocator& other) noexcept
+        : memoryResource(other.memoryResource)
+    {
+    }
 
-    template <typename U> Allocator(const Allocator<U, Alignment>& /* other */) noexcept {}
+    template <typename U>
+    Allocator(const Allocator<U, Alignment>& other) noexcept
+        : memoryResource(other.resource())
+    {
+    }
 
     ~Allocator() {}
 
@@ -70,14 +125,25 @@ template <class T, size_t Alignment = std::max(alignof(T), alignof(void*))> stru
 
     pointer allocate(size_type n, [[maybe_unused]] const void* hint = 0)
     {
-        size_t alignment = Alignment;
-        n = std::max(n, alignment);
-        pointer p = reinterpret_cast<pointer>(SLOT_MAP_ALLOC((sizeof(value_type) * n), alignment));
+        size_t numBytes = allocationSize(n);
+        pointer p = reinterpret_cast<pointer>(memoryResource ? memoryResource->allocate(numBytes, Alignment) : SLOT_MAP_ALLOC(numBytes, Alignment));
         SLOT_MAP_ASSERT(p);
         return p;
     }
 
-    void deallocate(pointer p, size_type /* n */) { SLOT_MAP_FREE(p); }
+    void deallocate(pointer p, size_type n)
+    {
+        if (memoryResource)
+        {
+            memoryResource->deallocate(p, allocationSize(n), Alignment);
+        }
+        else
+        {
+            SLOT_MAP_FREE(p);
+        }
+    }
+
+    std::pmr::memory_resource* resource() const noexcept { return memoryResource; }
 
     size_type max_size() const noexcept { return std::numeric_limits<size_type>::max() / sizeof(value_type); }
 
@@ -86,18 +152,29 @@ template <class T, size_t Alignment = std::max(alignof(T), alignof(void*))> stru
         new (reinterpret_cast<void*>(p)) U(std::forward<Args>(args)...);
     }
     template <class U> void destroy(U* p) { p->~U(); }
+
+  private:
+    static size_t allocationSize(size_type n) noexcept
+    {
+        size_t alignment = Alignment;
+        n = std::max(n, alignment);
+        // aligned_alloc requires the size to be a multiple of the alignment
+        return (sizeof(value_type) * n + (alignment - 1)) & ~(alignment - 1);
+    }
+
+    std::pmr::memory_resource* memoryResource;
 };
 
 template <class T1, class T2, size_t Alignment>
-bool operator==(const Allocator<T1, Alignment>& /*lhs*/, const Allocator<T2, Alignment>& /*rhs*/) noexcept
+bool operator==(const Allocator<T1, Alignment>& lhs, const Allocator<T2, Alignment>& rhs) noexcept
 {
-    return true;
+    return lhs.resource() == rhs.resource();
 }
 
 template <class T1, class T2, size_t Alignment>
-bool operator!=(const Allocator<T1, Alignment>& /*lhs*/, const Allocator<T2, Alignment>& /*rhs*/) noexcept
+bool operator!=(const Allocator<T1, Alignment>& lhs, const Allocator<T2, Alignment>& rhs) noexcept
 {
-    return false;
+    return lhs.resource() != rhs.resource();
 }
 } // namespace stl
 
@@ -137,8 +214,13 @@ template <typename T> struct slot_map_key64
     static inline constexpr version_t kInvalidVersion = 0x0u;
     static inline constexpr version_t kMinVersion = 0x1u;
     static inline constexpr version_t kMaxVersion = 0x0fffffu;
+    static inline constexpr uint32_t kNumVersionBits = 20;
     static inline constexpr index_t kMaxIndex = 0xffffffffu;
     static inline constexpr tag_t kMaxTag = 0x0fffu;
+
+    // no page epoch (see slot_map_key64_epoch)
+    static inline constexpr uint32_t kNumEpochBits = 0;
+    static inline constexpr version_t kMaxEpoch = 0;
     
     static inline constexpr id_type kIndexMask = 0x00000000ffffffffull;
     
@@ -203,13 +285,114 @@ template <typename T> struct slot_map_key64
 
 /*
 
+64-bit key with a page epoch (see slot_map::reclaim_inactive_pages)
+
+| Component      |  Number of bits                     |
+| ---------------|-------------------------------------|
+| tag            |  12 - EPOCH_BITS                    |
+| epoch          |  EPOCH_BITS (1..10, default 10)     |
+| version        |  20 (0..1,048,575                   |
+| index          |  32 (0..4,294,967,295)              |
+
+The epoch takes the bits of the tag, the index range is the same as slot_map_key64.
+With the default 10 epoch bits every index hands out 1024 * 1M keys before it retires for good.
+
+*/
+template <typename T, uint32_t EPOCH_BITS = 10> struct slot_map_key64_epoch
+{
+    static_assert(EPOCH_BITS >= 1 && EPOCH_BITS <= 10, "The page epoch has to fit into the spare bits of the slot meta word");
+
+    using id_type = uint64_t;
+    using version_t = uint32_t;
+    using index_t = uint32_t;
+    using tag_t = uint16_t;
+
+    static inline constexpr version_t kInvalidVersion = 0x0u;
+    static inline constexpr version_t kMinVersion = 0x1u;
+    static inline constexpr version_t kMaxVersion = 0x0fffffu;
+    static inline constexpr uint32_t kNumVersionBits = 20;
+    static inline constexpr index_t kMaxIndex = 0xffffffffu;
+    static inline constexpr tag_t kMaxTag = static_cast<tag_t>(0x0fffu >> EPOCH_BITS);
+
+    static inline constexpr uint32_t kNumEpochBits = EPOCH_BITS;
+    static inline constexpr version_t kMaxEpoch = static_cast<version_t>((1u << EPOCH_BITS) - 1);
+
+    static inline constexpr id_type kIndexMask = 0x00000000ffffffffull;
+
+    static inline constexpr id_type kVersionMask = 0x0fffff00000000ull;
+    static inline constexpr id_type kVersionShift = 32ull;
+
+    static inline constexpr id_type kEpochShift = 52ull;
+    static inline constexpr id_type kEpochMask = static_cast<id_type>(kMaxEpoch) << kEpochShift;
+
+    static inline constexpr id_type kHandleTagMask = 0xfff0000000000000ull << EPOCH_BITS;
+    static inline constexpr id_type kHandleTagShift = 52ull + EPOCH_BITS;
+
+    static inline constexpr slot_map_key64_epoch make(version_t version, index_t index, version_t epoch = 0) noexcept
+    {
+        SLOT_MAP_ASSERT(version != kInvalidVersion);
+        SLOT_MAP_ASSERT(index <= kMaxIndex);
+        SLOT_MAP_ASSERT(epoch <= kMaxEpoch);
+        id_type v = (static_cast<id_type>(version) << kVersionShift) & kVersionMask;
+        id_type e = (static_cast<id_type>(epoch) << kEpochShift) & kEpochMask;
+        id_type i = (static_cast<id_type>(index)) & kIndexMask;
+        return slot_map_key64_epoch{v | e | i};
+    }
+
+    inline size_t hash() const noexcept { return std::hash<id_type>{}(raw); }
+
+    static inline slot_map_key64_epoch clearTagAndUpdateVersion(slot_map_key64_epoch key, version_t version) noexcept
+    {
+        SLOT_MAP_ASSERT(version != kInvalidVersion);
+        id_type ver = (static_cast<id_type>(version) << kVersionShift) & kVersionMask;
+        return slot_map_key64_epoch{((key.raw & (~kVersionMask)) | ver) & (~kHandleTagMask)};
+    }
+    static inline index_t toIndex(slot_map_key64_epoch key) noexcept { return static_cast<index_t>(key.raw & kIndexMask); }
+    static inline version_t toEpoch(slot_map_key64_epoch key) noexcept { return static_cast<version_t>((key.raw & kEpochMask) >> kEpochShift); }
+    static inline version_t toVersion(slot_map_key64_epoch key) noexcept
+    {
+        return static_cast<version_t>((key.raw & kVersionMask) >> kVersionShift);
+    }
+    static inline version_t increaseVersion(version_t version) noexcept { return (version + 1); }
+
+    inline tag_t get_tag() const noexcept { return static_cast<tag_t>((raw & kHandleTagMask) >> kHandleTagShift); }
+    inline void set_tag(tag_t tag) noexcept
+    {
+        SLOT_MAP_ASSERT(tag <= kMaxTag);
+        id_type ud = (static_cast<id_type>(tag) << kHandleTagShift) & kHandleTagMask;
+        raw = ((raw & (~kHandleTagMask)) | ud);
+    }
+
+    slot_map_key64_epoch() noexcept = default;
+    explicit slot_map_key64_epoch(id_type raw) noexcept
+        : raw(raw)
+    {
+    }
+    slot_map_key64_epoch(const slot_map_key64_epoch&) noexcept = default;
+    slot_map_key64_epoch& operator=(const slot_map_key64_epoch&) noexcept = default;
+    slot_map_key64_epoch(slot_map_key64_epoch&&) noexcept = default;
+    slot_map_key64_epoch& operator=(slot_map_key64_epoch&&) noexcept = default;
+
+    bool operator==(const slot_map_key64_epoch& other) const noexcept { return raw == other.raw; }
+    bool operator<(const slot_map_key64_epoch& other) const noexcept { return raw < other.raw; }
+
+    // implicit conversion to id_type (useful for printing and debug)
+    operator id_type() const noexcept { return raw; }
+
+    static inline slot_map_key64_epoch invalid() noexcept { return slot_map_key64_epoch{0}; }
+
+    id_type raw;
+};
+
+/*
+
 32-bit key
 
-| Component      |  Number of bits     |
-| ---------------|---------------------|
-| tag            |  2                  |
-| version        |  10 (0..1023)       |
-| index          |  20 (0..1,048,576)  |
+| Component      |  Number of bits        |
+| ---------------|------------------------|
+| tag            |  2                     |
+| version        |  10 (0..1023)          |
+| index          |  20 (0..1,048,576)     |
 
 */
 template <typename T> struct slot_map_key32
@@ -221,12 +404,17 @@ template <typename T> struct slot_map_key32
 
     static inline constexpr version_t kInvalidVersion = 0x0u;
     static inline constexpr version_t kMinVersion = 0x1u;
-    static inline constexpr version_t kMaxVersion = 0x0400u;
+    static inline constexpr version_t kMaxVersion = 0x03ffu;
+    static inline constexpr uint32_t kNumVersionBits = 10;
     static inline constexpr index_t kMaxIndex = 0x000fffffu;
     static inline constexpr tag_t kMaxTag = 0x03u;
 
-    static inline constexpr id_type kIndexMask = 0x0fffffull;
+    // no page epoch (see slot_map_key32_epoch)
+    static inline constexpr uint32_t kNumEpochBits = 0;
+    static inline constexpr version_t kMaxEpoch = 0;
 
+    static inline constexpr id_type kIndexMask = 0x0fffffull;
+    
     static inline constexpr id_type kVersionMask = 0x3ff00000ull;
     static inline constexpr id_type kVersionShift = 20ull;
 
@@ -286,6 +474,257 @@ template <typename T> struct slot_map_key32
     id_type raw;
 };
 
+/*
+
+32-bit key with a page epoch (see slot_map::reclaim_inactive_pages)
+
+| Component      |  Number of bits        |
+| ---------------|------------------------|
+| tag            |  2 - EPOCH_BITS        |
+| epoch          |  EPOCH_BITS (1..2, default 2) |
+| version        |  10 (0..1023)          |
+| index          |  20 (0..1,048,576)     |
+
+The epoch takes the bits of the tag (no tag with the default 2 epoch bits), the index range is the same as slot_map_key32.
+With the default 2 epoch bits every index hands out 4 * 1023 keys before it retires for good.
+
+*/
+template <typename T, uint32_t EPOCH_BITS = 2> struct slot_map_key32_epoch
+{
+    static_assert(EPOCH_BITS >= 1 && EPOCH_BITS <= 2, "The page epoch takes the tag bits of the key");
+
+    using id_type = uint32_t;
+    using version_t = uint16_t;
+    using index_t = uint32_t;
+    using tag_t = uint8_t;
+
+    static inline constexpr version_t kInvalidVersion = 0x0u;
+    static inline constexpr version_t kMinVersion = 0x1u;
+    static inline constexpr version_t kMaxVersion = 0x03ffu;
+    static inline constexpr uint32_t kNumVersionBits = 10;
+    static inline constexpr index_t kMaxIndex = 0x000fffffu;
+    static inline constexpr tag_t kMaxTag = static_cast<tag_t>(0x03u >> EPOCH_BITS);
+
+    static inline constexpr uint32_t kNumEpochBits = EPOCH_BITS;
+    static inline constexpr version_t kMaxEpoch = static_cast<version_t>((1u << EPOCH_BITS) - 1);
+
+    static inline constexpr id_type kIndexMask = 0x0fffffull;
+
+    static inline constexpr id_type kVersionMask = 0x3ff00000ull;
+    static inline constexpr id_type kVersionShift = 20ull;
+
+    static inline constexpr id_type kEpochShift = 30ull;
+    static inline constexpr id_type kEpochMask = static_cast<id_type>(kMaxEpoch) << kEpochShift;
+
+    // note: the tag is shifted as a 64-bit value (the shift is 32 when the epoch takes every tag bit)
+    static inline constexpr uint64_t kHandleTagMask = (0xc0000000ull << EPOCH_BITS) & 0xffffffffull;
+    static inline constexpr uint64_t kHandleTagShift = 30ull + EPOCH_BITS;
+
+    static inline constexpr slot_map_key32_epoch make(version_t version, index_t index, version_t epoch = 0) noexcept
+    {
+        SLOT_MAP_ASSERT(version != kInvalidVersion);
+        SLOT_MAP_ASSERT(index <= kMaxIndex);
+        SLOT_MAP_ASSERT(epoch <= kMaxEpoch);
+        id_type v = (static_cast<id_type>(version) << kVersionShift) & kVersionMask;
+        id_type e = (static_cast<id_type>(epoch) << kEpochShift) & kEpochMask;
+        id_type i = (static_cast<id_type>(index)) & kIndexMask;
+        return slot_map_key32_epoch{v | e | i};
+    }
+
+    inline size_t hash() const noexcept { return std::hash<id_type>{}(raw); }
+
+    static inline slot_map_key32_epoch clearTagAndUpdateVersion(slot_map_key32_epoch key, version_t version) noexcept
+    {
+        SLOT_MAP_ASSERT(version != kInvalidVersion);
+        id_type ver = (static_cast<id_type>(version) << kVersionShift) & kVersionMask;
+        return slot_map_key32_epoch{static_cast<id_type>(((key.raw & (~kVersionMask)) | ver) & (~kHandleTagMask))};
+    }
+    static inline index_t toIndex(slot_map_key32_epoch key) noexcept { return static_cast<index_t>(key.raw & kIndexMask); }
+    static inline version_t toEpoch(slot_map_key32_epoch key) noexcept { return static_cast<version_t>((key.raw & kEpochMask) >> kEpochShift); }
+    static inline version_t toVersion(slot_map_key32_epoch key) noexcept
+    {
+        return static_cast<version_t>((key.raw & kVersionMask) >> kVersionShift);
+    }
+    static inline version_t increaseVersion(version_t version) noexcept { return (version + 1); }
+
+    inline tag_t get_tag() const noexcept { return static_cast<tag_t>((static_cast<uint64_t>(raw) & kHandleTagMask) >> kHandleTagShift); }
+    inline void set_tag(tag_t tag) noexcept
+    {
+        SLOT_MAP_ASSERT(tag <= kMaxTag);
+        uint64_t ud = (static_cast<uint64_t>(tag) << kHandleTagShift) & kHandleTagMask;
+        raw = static_cast<id_type>((raw & (~kHandleTagMask)) | ud);
+    }
+
+    slot_map_key32_epoch() noexcept = default;
+    explicit slot_map_key32_epoch(id_type raw) noexcept
+        : raw(raw)
+    {
+    }
+    slot_map_key32_epoch(const slot_map_key32_epoch&) noexcept = default;
+    slot_map_key32_epoch& operator=(const slot_map_key32_epoch&) noexcept = default;
+    slot_map_key32_epoch(slot_map_key32_epoch&&) noexcept = default;
+    slot_map_key32_epoch& operator=(slot_map_key32_epoch&&) noexcept = default;
+
+    bool operator==(const slot_map_key32_epoch& other) const noexcept { return raw == other.raw; }
+    bool operator<(const slot_map_key32_epoch& other) const noexcept { return raw < other.raw; }
+
+    // implicit conversion to id_type (useful for printing and debug)
+    operator id_type() const noexcept { return raw; }
+
+    static inline slot_map_key32_epoch invalid() noexcept { return slot_map_key32_epoch{0}; }
+
+    id_type raw;
+};
+
+/*
+  Page layouts (see slot_map TLayout template parameter)
+
+  slot_map_layout_split (default)
+    [value, value, value, ...][meta, meta, meta, ...]
+    Values are packed together, best for iteration-heavy use.
+
+  slot_map_layout_interleaved
+    [meta, value][meta, value][meta, value]...
+    Every slot's meta is stored right next to its value, so a random lookup (version check + value access) touches a single
+    cache line instead of two cache lines that are far apart. Best for random access workloads with small T.
+
+  slot_map_layout_dense_meta
+    [value, value, value, ...] + one contiguous version table for all the slots (indexed by global slot index)
+    Key validation (has_key, stale key filtering) only scans the small version table, value pages are touched only on a confirmed hit.
+    The version table is a single array on purpose (not per-page blocks): a lookup is one load at the slot index, without the page table,
+    and the contiguous layout has no page pointers at all. The cost: the table doubles its capacity when it grows, which copies
+    the whole table (sizeof(version_t) per slot, e.g. 4 MB for 1M slots of slot_map_key64) and briefly needs the old and the new
+    allocation. Call reserve() up front to avoid the copy on the emplace path. The table is released by shrink_to_fit (trailing
+    released pages only) and reset, not page by page.
+
+  slot_map_layout_contiguous
+    [value, value, value, ...] for all the pages in a single growable array + the dense version table
+    No pointer stability: values are moved when the array grows. Value access is a plain offset (no page indirection in get),
+    iteration is a single linear stream. Memory of released pages is kept until reset.
+*/
+struct slot_map_layout_split
+{
+};
+
+struct slot_map_layout_interleaved
+{
+};
+
+struct slot_map_layout_dense_meta
+{
+};
+
+struct slot_map_layout_contiguous
+{
+};
+
+/*
+  Free slot reuse policy (see slot_map::set_reuse_policy)
+
+  Both policies let recycled slots rest for kMinFreeIndices erases before reuse (version longevity).
+  fifo        - rested slots are reused in erase order (oldest first), new values are scattered across all the partially used pages.
+  dense_first - rested slots are reused from the densest pages first, so sparse pages drain completely (dense iteration, small resident set
+                after churn spikes, drained pages could be released by shrink_to_fit).
+*/
+enum class slot_map_reuse_policy : uint8_t
+{
+    fifo,
+    dense_first,
+};
+
+/*
+  Page memory provider (see slot_map::set_page_allocator)
+  Every page remembers the allocator it was allocated from, so the allocator could be changed at any time.
+  Note: slot_map_page_pool (slot_map_page_pool.h) is a ready to use implementation that recycles page blocks across slot map instances.
+*/
+class slot_map_page_allocator
+{
+  public:
+    virtual ~slot_map_page_allocator() = default;
+    virtual void* allocate_page(size_t sizeInBytes, size_t alignment) = 0;
+    virtual void free_page(void* ptr, size_t sizeInBytes, size_t alignment) noexcept = 0;
+};
+
+/*
+  Index of the lowest set bit (`v` must not be zero), used to walk the live slots bitmaps
+*/
+inline uint32_t slot_map_count_trailing_zeros(uint64_t v) noexcept
+{
+    SLOT_MAP_ASSERT(v != 0);
+#if defined(_MSC_VER)
+    unsigned long res;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&res, v);
+#else
+    if (_BitScanForward(&res, static_cast<unsigned long>(v)) == 0)
+    {
+        _BitScanForward(&res, static_cast<unsigned long>(v >> 32));
+        res += 32;
+    }
+#endif
+    return static_cast<uint32_t>(res);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(v));
+#endif
+}
+
+/*
+  Bytes of a single page of `numElements` slots (values + versions + live slots bitmap + alignment padding) for the given layout
+  note: mirrors slot_map::getPageLayout (checked by a static_assert in slot_map)
+*/
+template <typename T, typename TKeyType = slot_map_key64<T>, typename TLayout = slot_map_layout_split>
+constexpr size_t slot_map_page_bytes_for_size(size_t numElements) noexcept
+{
+    auto alignUp = [](size_t cursor, size_t alignment) { return (cursor + (alignment - 1)) & ~(alignment - 1); };
+    const size_t metaSize = sizeof(typename TKeyType::version_t);
+    const size_t metaAlign = alignof(typename TKeyType::version_t);
+    // note: a value slot is at least sizeof(index_t) (tombstoned slots store the free list links)
+    const size_t valueAlign = std::max(alignof(T), alignof(typename TKeyType::index_t));
+    const size_t valueSize = alignUp(std::max(sizeof(T), sizeof(typename TKeyType::index_t)), valueAlign);
+
+    size_t slotsEnd = 0;
+    if constexpr (std::is_same<TLayout, slot_map_layout_interleaved>::value)
+    {
+        const size_t stride = alignUp(alignUp(metaSize, valueAlign) + valueSize, std::max(metaAlign, valueAlign));
+        slotsEnd = stride * numElements;
+    }
+    else if constexpr (std::is_same<TLayout, slot_map_layout_dense_meta>::value || std::is_same<TLayout, slot_map_layout_contiguous>::value)
+    {
+        slotsEnd = valueSize * numElements;
+    }
+    else
+    {
+        slotsEnd = alignUp(valueSize * numElements, metaAlign) + metaSize * numElements;
+    }
+    const size_t bitmapOffset = alignUp(slotsEnd, alignof(uint64_t));
+    const size_t bitmapSize = ((numElements + 63) / 64) * sizeof(uint64_t);
+    const size_t alignment = std::max(std::max(std::max(metaAlign, valueAlign), alignof(uint64_t)), size_t(16));
+    return alignUp(bitmapOffset + bitmapSize, alignment);
+}
+
+/*
+  Page size (in elements) derived from a page byte budget
+
+  Returns the largest power of two number of elements whose page (values + versions + live slots bitmap + alignment padding)
+  fits into `pageBytes` with the given layout, so maps with different value types get the same allocation granularity
+  (e.g. 64 KB or 2 MB huge pages). Values that don't fit into the budget get one element per page.
+
+  ```
+  dod::slot_map64<BigStruct, dod::slot_map_page_size_for_bytes<BigStruct>(2 * 1024 * 1024)> bigStructs;
+  dod::slot_map64_page_bytes<BigStruct, 2 * 1024 * 1024> sameAsAbove;
+  ```
+*/
+template <typename T, typename TKeyType = slot_map_key64<T>, typename TLayout = slot_map_layout_split>
+constexpr size_t slot_map_page_size_for_bytes(size_t pageBytes) noexcept
+{
+    size_t numElements = 1;
+    while (slot_map_page_bytes_for_size<T, TKeyType, TLayout>(numElements * 2) <= pageBytes)
+    {
+        numElements *= 2;
+    }
+    return numElements;
+}
+
 /*
   A slot map is a high-performance associative container with persistent unique keys to access stored values. Upon insertion, a key is
   returned that can be used to later access or remove the values. Insertion, removal, and access are all guaranteed to take O(1) time (best,
@@ -360,10 +799,17 @@ template <typename T> struct slot_map_key32
   Init, Update, Draw - Data Arrays, 2012
   https://greysphere.tumblr.com/post/31601463396/data-arrays
 */
-template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64> class slot_map
+template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64,
+          typename TLayout = slot_map_layout_split>
+class slot_map
 {
+    static_assert(std::is_same<TLayout, slot_map_layout_split>::value || std::is_same<TLayout, slot_map_layout_interleaved>::value ||
+                      std::is_same<TLayout, slot_map_layout_dense_meta>::value || std::is_same<TLayout, slot_map_layout_contiguous>::value,
+                  "Unsupported page layout");
+
   public:
     using key = TKeyType;
+    using layout = TLayout;
     using version_t = typename TKeyType::version_t;
     using index_t = typename TKeyType::index_t;
     using tag_t = typename TKeyType::tag_t;
@@ -385,7 +831,7 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
         kMinFreeIndices = 64 (default)
 
         When a slot is reused, its version is automatically incremented (to make existing keys invalid).
-        But since we only use 16-bits for version numbers, there is a possibility that the version counter will wrap around,
+        But since we only use a few bits for version numbers (20 for 64-bit keys, 10 for 32-bit keys), the version counter could wrap around,
         and a new item will get the same key as a removed item.
 
         Once the version counter overflows, we disable that slot so that no new keys are returned for this slot
@@ -396,30 +842,247 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
     */
     static inline constexpr size_type kMinFreeIndices = static_cast<size_type>(MINFREEINDICES);
 
+    // adaptive reuse threshold: number of erases between threshold updates (see enable_adaptive_min_free_indices)
+    static inline constexpr size_type kAdaptiveWindow = 1024;
+
+    /*
+      Page allocation/release and slot deactivation events (see set_event_hooks)
+    */
+    struct EventInfo
+    {
+        // slot map instance (identity)
+        const void* slotMap;
+        // slot map type name (compiler-specific pretty name)
+        const char* typeName;
+        size_type pageIndex;
+        // slot index within the page (slot deactivation event only)
+        size_type slotIndex;
+        // page allocation size (page events only)
+        size_t sizeInBytes;
+    };
+
+    using EventCallback = void (*)(const EventInfo& info, void* userData);
+
+    struct EventHooks
+    {
+        EventCallback onPageAllocate = nullptr;
+        EventCallback onPageRelease = nullptr;
+        EventCallback onSlotDeactivate = nullptr;
+        void* userData = nullptr;
+    };
+
   private:
-    using ValueStorage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    /*
+      Tombstoned slots store the free list link (see pushFreeIndex), so a value slot is at least sizeof(index_t)
+      (types smaller than index_t pay the difference per slot, e.g. slot_map<uint8_t> uses 4 bytes per value).
+      note: the link can't live in the meta word of a tombstone instead: the meta word has to keep the version (to restore the key
+      on reuse) and the markers, the spare bits (10 for key64, 4 for key32, used by the optional page epoch) are far too few for an index.
+    */
+    using ValueStorage = typename std::aligned_storage<std::max(sizeof(T), sizeof(index_t)), std::max(alignof(T), alignof(index_t))>::type;
 
+    // end of the free list marker
+    static inline constexpr index_t kInvalidFreeIndex = std::numeric_limits<index_t>::max();
+    // end of the reuse bucket list marker
+    static inline constexpr size_type kInvalidPageIndex = std::numeric_limits<size_type>::max();
+    // dense_first reuse policy: pages with reusable slots are bucketed by occupancy (numAliveSlots * kNumReuseBuckets / kPageSize)
+    static inline constexpr size_type kNumReuseBuckets = 8;
+
+    /*
+      Packed slot meta: tombstone and inactive markers live in the two most significant bits of the version word.
+      A live slot stores just its version (both markers are zero), so a single compare (word == key version) validates a key.
+      With page epochs (key::kNumEpochBits != 0) the page epoch is stored right above the version (see getKeyWord).
+    */
     struct Meta
     {
-        version_t version; // note: 0 is reserved for kInvalidVersion
-        uint8_t tombstone; // note: we only need 1 bit for tombstone marker
-        uint8_t inactive;  // note: we only need 1 bit for inactive marker
+        static inline constexpr version_t kTombstoneBit = static_cast<version_t>(version_t(1) << (sizeof(version_t) * 8 - 1));
+        static inline constexpr version_t kInactiveBit = static_cast<version_t>(version_t(1) << (sizeof(version_t) * 8 - 2));
+        static inline constexpr version_t kVersionMask = static_cast<version_t>(~(kTombstoneBit | kInactiveBit));
+        // never matches any key version (used for never used slots and for the sentinel page)
+        static inline constexpr version_t kInvalidWord = static_cast<version_t>(kTombstoneBit | kInactiveBit);
+
+        version_t word; // note: version 0 is reserved for kInvalidVersion
+
+        version_t version() const noexcept { return static_cast<version_t>(word & kVersionMask); }
+        bool isTombstone() const noexcept { return (word & kTombstoneBit) != 0; }
+        bool isInactive() const noexcept { return (word & kInactiveBit) != 0; }
     };
 
-    struct Page
+    static_assert(sizeof(Meta) == sizeof(version_t), "Meta is expected to be packed into a single version word");
+    static_assert(key::kMaxVersion <= Meta::kVersionMask, "Key versions must not overlap with meta markers");
+    static_assert(((key::kMaxEpoch << key::kNumVersionBits) | key::kMaxVersion) <= Meta::kVersionMask,
+                  "Key epochs must not overlap with meta markers");
+
+    // meta word of the live slot a key points to (version + page epoch)
+    static version_t getKeyWord(key k) noexcept
     {
-        void* rawMemory;
-        ValueStorage* values;
-        Meta* meta;
-        size_type numInactiveSlots;
-        size_type numUsedElements;
+        if constexpr (key::kNumEpochBits == 0)
+        {
+            return key::toVersion(k);
+        }
+        else
+        {
+            return static_cast<version_t>(key::toVersion(k) | (key::toEpoch(k) << key::kNumVersionBits));
+        }
+    }
+
+    // key of a live slot from its meta word (version + page epoch)
+    static key makeKey(version_t word, index_t index) noexcept
+    {
+        if constexpr (key::kNumEpochBits == 0)
+        {
+            return key::make(word, index);
+        }
+        else
+        {
+            return key::make(static_cast<version_t>(word & key::kMaxVersion), index, static_cast<version_t>(word >> key::kNumVersionBits));
+        }
+    }
+
+    /*
+      Live slots bitmap (one bit per slot, 1 = slot holds a live value)
+      Iterators, clear(), copy and destruction use it to jump between live slots 64 at a time instead of visiting every slot's meta.
+    */
+    static inline constexpr size_type kBitsPerWord = 64;
+    static inline constexpr size_type kNumBitmapWords = (kPageSize + kBitsPerWord - 1) / kBitsPerWord;
+
+    static inline constexpr bool kInterleavedLayout = std::is_same<TLayout, slot_map_layout_interleaved>::value;
+    static inline constexpr bool kContiguousLayout = std::is_same<TLayout, slot_map_layout_contiguous>::value;
+    // versions are stored in the dense version table (metaTable) instead of pages
+    static inline constexpr bool kDenseMetaLayout = std::is_same<TLayout, slot_map_layout_dense_meta>::value || kContiguousLayout;
+
+    struct PageLayout
+    {
+        // slot i meta is at (metaOffset + i * metaStride), slot i value is at (valueOffset + i * valueStride)
+        size_type metaOffset;
+        size_type metaStride;
+        size_type valueOffset;
+        size_type valueStride;
+        // bytes used by meta/values (without padding)
+        size_type metaSize;
+        size_type dataSize;
+        size_type bitmapOffset;
+        size_type bitmapSize;
+        size_type numBytes;
+        size_type alignment;
+    };
+
+    /*
+      page memory layout:
+        split:       [ValueStorage * kPageSize][Meta * kPageSize][uint64_t * kNumBitmapWords]
+        interleaved: [{Meta, ValueStorage} * kPageSize][uint64_t * kNumBitmapWords]
+        dense meta:  [ValueStorage * kPageSize][uint64_t * kNumBitmapWords] (meta is stored in the dense version table)
+        contiguous:  the same as dense meta, but values and bitmaps of all the pages are stored in two contiguous arrays (see ContiguousStorage)
+    */
+    static constexpr PageLayout getPageLayout() noexcept
+    {
+        PageLayout layout{};
+        layout.metaSize = static_cast<size_type>(sizeof(Meta)) * kPageSize;
+        layout.bitmapSize = static_cast<size_type>(sizeof(uint64_t)) * kNumBitmapWords;
+        layout.dataSize = static_cast<size_type>(sizeof(ValueStorage)) * kPageSize;
+        size_type slotsEnd = 0;
+        if constexpr (kInterleavedLayout)
+        {
+            const size_type recordAlignment = std::max(static_cast<size_type>(alignof(Meta)), static_cast<size_type>(alignof(ValueStorage)));
+            layout.metaOffset = 0;
+            layout.valueOffset = align(static_cast<size_type>(sizeof(Meta)), static_cast<size_type>(alignof(ValueStorage)));
+            layout.metaStride = align(layout.valueOffset + static_cast<size_type>(sizeof(ValueStorage)), recordAlignment);
+            layout.valueStride = layout.metaStride;
+            slotsEnd = layout.metaStride * kPageSize;
+        }
+        else if constexpr (kDenseMetaLayout)
+        {
+            layout.valueOffset = 0;
+            layout.valueStride = static_cast<size_type>(sizeof(ValueStorage));
+            layout.metaOffset = 0;
+            layout.metaStride = static_cast<size_type>(sizeof(Meta));
+            layout.metaSize = 0;
+            slotsEnd = layout.dataSize;
+        }
+        else
+        {
+            layout.valueOffset = 0;
+            layout.valueStride = static_cast<size_type>(sizeof(ValueStorage));
+            layout.metaOffset = align(layout.dataSize, static_cast<size_type>(alignof(Meta)));
+            layout.metaStride = static_cast<size_type>(sizeof(Meta));
+            slotsEnd = layout.metaOffset + layout.metaSize;
+        }
+        layout.bitmapOffset = align(slotsEnd, static_cast<size_type>(alignof(uint64_t)));
+        layout.alignment = std::max(static_cast<size_type>(alignof(Meta)), static_cast<size_type>(alignof(ValueStorage)));
+        layout.alignment = std::max(layout.alignment, static_cast<size_type>(alignof(uint64_t)));
+        // some platforms (macOS) does not support alignments smaller than `alignof(void*)`
+        // and 16 bytes seem like a nice compromise
+        layout.alignment = std::max(layout.alignment, 16u);
+
+        /*
+          C++11 std::aligned_alloc
+
+          Passing a size which is not an integral multiple of alignment or an alignment which is not valid or not supported by the
+          implementation causes the function to fail and return a null pointer (C11, as published, specified undefined behavior in
+          this case, this was corrected by DR 460)
+        */
+        layout.numBytes = align(layout.bitmapOffset + layout.bitmapSize, layout.alignment);
+        return layout;
+    }
+
+    // the layout only depends on the template parameters, computed once at compile time
+    static inline constexpr PageLayout kPageLayout = getPageLayout();
+
+    static const Meta& getMetaAt(const Meta* meta, size_type index) noexcept
+    {
+        SLOT_MAP_ASSERT(meta);
+        const char* res = reinterpret_cast<const char*>(meta) + static_cast<size_t>(index) * kPageLayout.metaStride;
+        return *reinterpret_cast<const Meta*>(res);
+    }
+
+    // returns the value that belongs to the given meta (slot `index` of the page)
+    static const ValueStorage& getValueByMeta(const Meta& m, size_type index) noexcept
+    {
+        const PageLayout& layout = kPageLayout;
+        const char* pageMemory = reinterpret_cast<const char*>(&m) - (layout.metaOffset + static_cast<size_t>(index) * layout.metaStride);
+        return *reinterpret_cast<const ValueStorage*>(pageMemory + layout.valueOffset + static_cast<size_t>(index) * layout.valueStride);
+    }
+
+    struct Page
+    {
+        void* rawMemory;
+        // both nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE
+        slot_map_page_allocator* allocator;
+        std::pmr::memory_resource* resource;
+        ValueStorage* values;
+        Meta* meta;
+        uint64_t* liveBits;
+        size_type numInactiveSlots;
+        size_type numUsedElements;
+        // page-level summary of the live slots bitmap (pages without live slots are skipped in O(1))
+        size_type numAliveSlots;
+        // dense_first reuse policy: page-local stack of rested slots and links of the occupancy bucket list (see pushReadyIndex)
+        index_t readyHead;
+        size_type numReadySlots;
+        size_type readyBucket;
+        size_type prevReadyPage;
+        size_type nextReadyPage;
+        // number of times the page has been reclaimed after retirement (see reclaim_inactive_pages)
+        version_t epoch;
+        // meta word (version + epoch) of the never used slots, above every version of a released page with the same index (see shrink_to_fit)
+        version_t baseWord;
 
         Page() noexcept
             : rawMemory(nullptr)
+            , allocator(nullptr)
+            , resource(nullptr)
             , values(nullptr)
             , meta(nullptr)
+            , liveBits(nullptr)
             , numInactiveSlots(0)
             , numUsedElements(0)
+            , numAliveSlots(0)
+            , readyHead(kInvalidFreeIndex)
+            , numReadySlots(0)
+            , readyBucket(0)
+            , prevReadyPage(kInvalidPageIndex)
+            , nextReadyPage(kInvalidPageIndex)
+            , epoch(0)
+            , baseWord(key::kMinVersion)
         {
         }
 
@@ -428,16 +1091,38 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
         Page& operator=(Page&&) = delete;
         Page(Page&& other) noexcept
             : rawMemory(nullptr)
+            , allocator(nullptr)
+            , resource(nullptr)
             , values(nullptr)
             , meta(nullptr)
+            , liveBits(nullptr)
             , numInactiveSlots(0)
             , numUsedElements(0)
+            , numAliveSlots(0)
+            , readyHead(kInvalidFreeIndex)
+            , numReadySlots(0)
+            , readyBucket(0)
+            , prevReadyPage(kInvalidPageIndex)
+            , nextReadyPage(kInvalidPageIndex)
+            , epoch(0)
+            , baseWord(key::kMinVersion)
         {
             std::swap(rawMemory, other.rawMemory);
+            std::swap(allocator, other.allocator);
+            std::swap(resource, other.resource);
             std::swap(meta, other.meta);
             std::swap(values, other.values);
+            std::swap(liveBits, other.liveBits);
             std::swap(numInactiveSlots, other.numInactiveSlots);
             std::swap(numUsedElements, other.numUsedElements);
+            std::swap(numAliveSlots, other.numAliveSlots);
+            std::swap(readyHead, other.readyHead);
+            std::swap(numReadySlots, other.numReadySlots);
+            std::swap(readyBucket, other.readyBucket);
+            std::swap(prevReadyPage, other.prevReadyPage);
+            std::swap(nextReadyPage, other.nextReadyPage);
+            std::swap(epoch, other.epoch);
+            std::swap(baseWord, other.baseWord);
         }
         ~Page() { deallocate(); }
 
@@ -450,306 +1135,1174 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
                 return;
             }
             SLOT_MAP_ASSERT(values);
-            SLOT_MAP_ASSERT(meta);
+            SLOT_MAP_ASSERT(meta || kDenseMetaLayout);
+            SLOT_MAP_ASSERT(liveBits);
 
-            SLOT_MAP_FREE(rawMemory);
+            // note: contiguous layout pages don't own memory (see ContiguousStorage)
+            if constexpr (!kContiguousLayout)
+            {
+                const PageLayout& layout = kPageLayout;
+                if (allocator)
+                {
+                    allocator->free_page(rawMemory, static_cast<size_t>(layout.numBytes), static_cast<size_t>(layout.alignment));
+                }
+                else if (resource)
+                {
+                    resource->deallocate(rawMemory, static_cast<size_t>(layout.numBytes), static_cast<size_t>(layout.alignment));
+                }
+                else
+                {
+                    SLOT_MAP_FREE(rawMemory);
+                }
+            }
             rawMemory = nullptr;
+            allocator = nullptr;
+            resource = nullptr;
             values = nullptr;
             meta = nullptr;
+            liveBits = nullptr;
+            numAliveSlots = 0;
         }
 
-        void allocate()
+        // note: the page allocator takes precedence over the memory resource
+        void allocate(slot_map_page_allocator* pageAllocator, std::pmr::memory_resource* memoryResource)
         {
+            static_assert(!kContiguousLayout, "Contiguous layout pages are attached to ContiguousStorage");
             SLOT_MAP_ASSERT(!rawMemory);
             SLOT_MAP_ASSERT(!values);
             SLOT_MAP_ASSERT(!meta);
 
-            size_type metaSize = static_cast<size_type>(sizeof(Meta)) * kPageSize;
-            size_type dataSize = static_cast<size_type>(sizeof(ValueStorage)) * kPageSize;
-            size_type alignedDataSize = align(dataSize, static_cast<size_type>(alignof(Meta)));
-            size_type alignment = std::max(static_cast<size_type>(alignof(Meta)), static_cast<size_type>(alignof(ValueStorage)));
-            // some platforms (macOS) does not support alignments smaller than `alignof(void*)`
-            // and 16 bytes seem like a nice compromise
-            alignment = std::max(alignment, 16u);
-            size_type numBytes = alignedDataSize + metaSize;
-
-            /*
-              C++11 std::aligned_alloc
-
-              Passing a size which is not an integral multiple of alignment or an alignment which is not valid or not supported by the
-              implementation causes the function to fail and return a null pointer (C11, as published, specified undefined behavior in
-              this case, this was corrected by DR 460)
-            */
-            numBytes = align(numBytes, alignment);
-            SLOT_MAP_ASSERT((numBytes % alignment) == 0);
-            rawMemory = SLOT_MAP_ALLOC(static_cast<size_t>(numBytes), static_cast<size_t>(alignment));
+            const PageLayout& layout = kPageLayout;
+            SLOT_MAP_ASSERT((layout.numBytes % layout.alignment) == 0);
+            if (pageAllocator)
+            {
+                rawMemory = pageAllocator->allocate_page(static_cast<size_t>(layout.numBytes), static_cast<size_t>(layout.alignment));
+            }
+            else if (memoryResource)
+            {
+                rawMemory = memoryResource->allocate(static_cast<size_t>(layout.numBytes), static_cast<size_t>(layout.alignment));
+            }
+            else
+            {
+                rawMemory = SLOT_MAP_ALLOC(static_cast<size_t>(layout.numBytes), static_cast<size_t>(layout.alignment));
+            }
             SLOT_MAP_ASSERT(rawMemory);
+            allocator = pageAllocator;
+            resource = pageAllocator ? nullptr : memoryResource;
 
             numInactiveSlots = 0;
             numUsedElements = 0;
-            values = reinterpret_cast<ValueStorage*>(rawMemory);
-            meta = reinterpret_cast<Meta*>(reinterpret_cast<char*>(rawMemory) + alignedDataSize);
+            numAliveSlots = 0;
+            values = reinterpret_cast<ValueStorage*>(reinterpret_cast<char*>(rawMemory) + layout.valueOffset);
+            liveBits = reinterpret_cast<uint64_t*>(reinterpret_cast<char*>(rawMemory) + layout.bitmapOffset);
+            std::memset(liveBits, 0, layout.bitmapSize);
+            if constexpr (!kDenseMetaLayout)
+            {
+                meta = reinterpret_cast<Meta*>(reinterpret_cast<char*>(rawMemory) + layout.metaOffset);
+                // lookups don't check bounds (see lookupMeta), so the slots that have never been used must not match any key
+                for (size_type i = 0; i < kPageSize; i++)
+                {
+                    metaAt(i).word = Meta::kInvalidWord;
+                }
+                SLOT_MAP_ASSERT(isPointerAligned(meta, alignof(Meta)));
+            }
 
-            // TODO: remove rawMemory member
-            SLOT_MAP_ASSERT(values == rawMemory);
             SLOT_MAP_ASSERT(values);
-            SLOT_MAP_ASSERT(meta);
             SLOT_MAP_ASSERT(isPointerAligned(values, alignof(ValueStorage)));
-            SLOT_MAP_ASSERT(isPointerAligned(meta, alignof(Meta)));
+            SLOT_MAP_ASSERT(isPointerAligned(liveBits, alignof(uint64_t)));
         }
-    };
 
-    static inline size_type align(size_type cursor, size_type alignment) noexcept { return (cursor + (alignment - 1)) & ~(alignment - 1); }
-    static inline bool isPointerAligned(void* cursor, size_t alignment) noexcept { return (uintptr_t(cursor) & (alignment - 1)) == 0; }
+        // contiguous layout: the page is a view of ContiguousStorage
+        void attach(ValueStorage* _values, uint64_t* _liveBits) noexcept
+        {
+            SLOT_MAP_ASSERT(!rawMemory);
+            rawMemory = _values;
+            values = _values;
+            liveBits = _liveBits;
+            numInactiveSlots = 0;
+            numUsedElements = 0;
+            numAliveSlots = 0;
+            std::memset(liveBits, 0, sizeof(uint64_t) * kNumBitmapWords);
+        }
 
-    template <typename TYPE, class... Args> static void construct(void* mem, Args&&... args)
-    {
-        new (mem) TYPE(std::forward<Args>(args)...);
-    }
-    template <typename TYPE> void destruct(TYPE* p) { p->~T(); }
+        // note: pages of the dense meta layout are active but have no meta
+        bool isActive() const noexcept { return rawMemory != nullptr; }
 
-    const T* getImpl(key k) const noexcept
-    {
-        index_t index = key::toIndex(k);
-        if (index > getMaxValidIndex())
+        const Meta& metaAt(size_type index) const noexcept { return getMetaAt(meta, index); }
+        Meta& metaAt(size_type index) noexcept { return const_cast<Meta&>(getMetaAt(meta, index)); }
+
+        const ValueStorage& valueAt(size_type index) const noexcept
         {
-            // index out of bounds
-            return nullptr;
+            SLOT_MAP_ASSERT(values && index < kPageSize);
+            const char* res = reinterpret_cast<const char*>(values) + static_cast<size_t>(index) * kPageLayout.valueStride;
+            return *reinterpret_cast<const ValueStorage*>(res);
         }
+        ValueStorage& valueAt(size_type index) noexcept { return const_cast<ValueStorage&>(static_cast<const Page*>(this)->valueAt(index)); }
 
-        PageAddr addr = getAddrFromIndex(index);
-        if (!isActivePage(addr))
+        bool isAlive(size_type index) const noexcept
         {
-            return nullptr;
+            SLOT_MAP_ASSERT(liveBits && index < kPageSize);
+            return (liveBits[index / kBitsPerWord] & (uint64_t(1) << (index % kBitsPerWord))) != 0;
         }
 
-        const Meta& m = getMetaByAddr(addr);
-
-        version_t version = key::toVersion(k);
-        if (m.version != version)
+        void setAlive(size_type index) noexcept
         {
-            // version mismatch, slot has been reused
-            return nullptr;
+            SLOT_MAP_ASSERT(!isAlive(index));
+            liveBits[index / kBitsPerWord] |= (uint64_t(1) << (index % kBitsPerWord));
+            numAliveSlots++;
         }
-        SLOT_MAP_ASSERT(m.version != key::kInvalidVersion);
-        SLOT_MAP_ASSERT(m.tombstone == 0);
-        SLOT_MAP_ASSERT(m.inactive == 0);
-
-        const ValueStorage& v = getValueByAddr(addr);
-        const T* value = reinterpret_cast<const T*>(&v);
-        return value;
-    }
 
-    index_t appendElement()
-    {
-        if (pages.empty() || pages.back().numUsedElements == kPageSize)
+        void setDead(size_type index) noexcept
         {
-            Page& p = pages.emplace_back();
-            p.allocate();
+            SLOT_MAP_ASSERT(isAlive(index));
+            liveBits[index / kBitsPerWord] &= ~(uint64_t(1) << (index % kBitsPerWord));
+            numAliveSlots--;
         }
-
-        Page& lastPage = pages.back();
-
-        size_type elementIndex = lastPage.numUsedElements;
-        SLOT_MAP_ASSERT(elementIndex <= kPageSize);
-        lastPage.numUsedElements++;
-
-        Meta& m = lastPage.meta[elementIndex];
-        m.version = key::kMinVersion;
-        m.tombstone = 0;
-        m.inactive = 0;
-
-        SLOT_MAP_ASSERT(pages.size() >= 1);
-        index_t index = static_cast<index_t>(getIndexFromAddr(PageAddr{static_cast<size_type>(pages.size()) - 1, elementIndex}));
-        return index;
-    }
-
-    struct PageAddr
-    {
-        size_type page;
-        size_type index;
     };
 
-    template <typename INTEGRAL_TYPE> inline static constexpr bool isPow2(INTEGRAL_TYPE x) noexcept
-    {
-        static_assert(std::is_integral<INTEGRAL_TYPE>::value, "isPow2 must be called on an integer type.");
-        return (x & (x - 1)) == 0 && (x != 0);
-    }
-
-    static inline PageAddr getAddrFromIndex(size_type index) noexcept
-    {
-        static_assert(isPow2(kPageSize), "kPageSize is expected to be a power of two.");
-        PageAddr res;
-        res.page = index / kPageSize;
-        res.index = index % kPageSize;
-        return res;
-    }
+    // some platforms (macOS) does not support alignments smaller than `alignof(void*)`
+    static inline constexpr size_t kContiguousAlignment = std::max(alignof(ValueStorage), size_t(16));
 
-    // to global index
-    static inline index_t getIndexFromAddr(PageAddr addr) noexcept
+    /*
+      Contiguous layout storage: values and live slots bitmaps of all the pages (capacity in pages, grows geometrically)
+      Pages are views of this storage, released pages keep their memory.
+    */
+    struct ContiguousStorage
     {
-        size_type index = (addr.page * kPageSize + addr.index);
-        return index_t(index);
-    }
+        ValueStorage* values;
+        uint64_t* bits;
+        size_type capacity;
+        // nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE
+        std::pmr::memory_resource* resource;
+
+        ContiguousStorage() noexcept
+            : values(nullptr)
+            , bits(nullptr)
+            , capacity(0)
+            , resource(nullptr)
+        {
+        }
 
-    const Meta& getMetaByAddrImpl(PageAddr addr) const noexcept
-    {
-        SLOT_MAP_ASSERT(addr.page < pages.size());
-        const Page& page = pages[addr.page];
-        SLOT_MAP_ASSERT(page.meta);
-        SLOT_MAP_ASSERT(addr.index < kPageSize);
-        return page.meta[addr.index];
-    }
+        ContiguousStorage(const ContiguousStorage&) = delete;
+        ContiguousStorage& operator=(const ContiguousStorage&) = delete;
+        ~ContiguousStorage() { release(); }
 
-    const ValueStorage& getValueByAddrImpl(PageAddr addr) const noexcept
-    {
-        SLOT_MAP_ASSERT(addr.page < pages.size());
-        const Page& page = pages[addr.page];
-        SLOT_MAP_ASSERT(page.values);
-        SLOT_MAP_ASSERT(addr.index < kPageSize);
-        return page.values[addr.index];
-    }
+        // aligned_alloc requires the size to be a multiple of the alignment
+        static size_t alignSize(size_t numBytes) noexcept { return (numBytes + (kContiguousAlignment - 1)) & ~(kContiguousAlignment - 1); }
+        static size_t valuesSizeInBytes(size_type numPages) noexcept
+        {
+            return alignSize(static_cast<size_t>(numPages) * kPageSize * sizeof(ValueStorage));
+        }
+        static size_t bitsSizeInBytes(size_type numPages) noexcept
+        {
+            return alignSize(static_cast<size_t>(numPages) * kNumBitmapWords * sizeof(uint64_t));
+        }
+        size_t numBytes() const noexcept { return capacity ? (valuesSizeInBytes(capacity) + bitsSizeInBytes(capacity)) : 0; }
 
-    const Meta& getMetaByAddr(PageAddr addr) const noexcept { return getMetaByAddrImpl(addr); }
-    const ValueStorage& getValueByAddr(PageAddr addr) const noexcept { return getValueByAddrImpl(addr); }
+        ValueStorage* pageValues(size_type pageIndex) const noexcept { return values + static_cast<size_t>(pageIndex) * kPageSize; }
+        uint64_t* pageBits(size_type pageIndex) const noexcept { return bits + static_cast<size_t>(pageIndex) * kNumBitmapWords; }
 
-    Meta& getMetaByAddr(PageAddr addr) noexcept
-    {
-        const Meta& constRes = getMetaByAddrImpl(addr);
-        return const_cast<Meta&>(constRes);
-    }
+        void swap(ContiguousStorage& other) noexcept
+        {
+            std::swap(values, other.values);
+            std::swap(bits, other.bits);
+            std::swap(capacity, other.capacity);
+            std::swap(resource, other.resource);
+        }
 
-    ValueStorage& getValueByAddr(PageAddr addr) noexcept
-    {
-        const ValueStorage& constRes = getValueByAddrImpl(addr);
-        return const_cast<ValueStorage&>(constRes);
-    }
+        void* allocateBlock(size_t numBytes) const
+        {
+            return resource ? resource->allocate(numBytes, kContiguousAlignment) : SLOT_MAP_ALLOC(numBytes, kContiguousAlignment);
+        }
 
-    bool isTombstone(size_type index) const noexcept
-    {
-        PageAddr addr = getAddrFromIndex(index);
-        SLOT_MAP_ASSERT(addr.page < pages.size());
-        const Page& page = pages[addr.page];
-        if (!page.meta)
+        void freeBlock(void* ptr, size_t numBytes) const noexcept
         {
-            return true;
+            if (resource)
+            {
+                resource->deallocate(ptr, numBytes, kContiguousAlignment);
+            }
+            else
+            {
+                SLOT_MAP_FREE(ptr);
+            }
         }
-        SLOT_MAP_ASSERT(addr.index < kPageSize);
-        return (page.meta[addr.index].tombstone != 0);
-    }
 
-    bool isActivePage(PageAddr addr) const noexcept
-    {
-        if (addr.page >= pages.size())
+        void release() noexcept
         {
-            return false;
+            if (values)
+            {
+                freeBlock(values, valuesSizeInBytes(capacity));
+            }
+            if (bits)
+            {
+                freeBlock(bits, bitsSizeInBytes(capacity));
+            }
+            values = nullptr;
+            bits = nullptr;
+            capacity = 0;
         }
-        const Page& page = pages[addr.page];
-        return (page.meta != nullptr);
-    }
+    };
 
-    size_type getMaxValidIndex() const noexcept { return maxValidIndex; }
+    // values are moved into the grown contiguous storage if that can't throw (or T can't be copied), copied otherwise
+    static inline constexpr bool kRelocateByMove = std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value;
 
-    void copyFrom(const slot_map& other)
+    // destroys the values already copied into the grown contiguous storage unless dismissed (the storage block is freed by its owner)
+    struct RelocationGuard
     {
-        reset();
+        const std::vector<Page, stl::Allocator<Page>>& pages;
+        const ContiguousStorage& newStorage;
+        size_t pageIndex = 0;
+        size_type numRelocated = 0;
+        bool dismissed = false;
 
-        SLOT_MAP_ASSERT(numItems == 0);
-        SLOT_MAP_ASSERT(maxValidIndex == 0);
-        SLOT_MAP_ASSERT(pages.empty());
-        SLOT_MAP_ASSERT(freeIndices.empty());
+        ~RelocationGuard()
+        {
+            if (dismissed)
+            {
+                return;
+            }
+            for (size_t i = 0; i <= pageIndex && i < pages.size(); i++)
+            {
+                const Page& page = pages[i];
+                if (!page.isActive())
+                {
+                    continue;
+                }
+                ValueStorage* newValues = newStorage.pageValues(static_cast<size_type>(i));
+                size_type numToDestroy = (i == pageIndex) ? numRelocated : page.numAliveSlots;
+                forEachAliveSlot(page, [&](size_type elementIndex) {
+                    if (numToDestroy == 0)
+                    {
+                        return false;
+                    }
+                    numToDestroy--;
+                    reinterpret_cast<T*>(&newValues[elementIndex])->~T();
+                    return true;
+                });
+            }
+        }
+    };
 
-        static_assert(std::is_standard_layout<Meta>::value && std::is_trivially_copyable<Meta>::value,
-                      "Meta is expected to be memcopyable (POD type)");
+    // makes sure the contiguous storage can hold `numPages` pages (relocates all the live values if the storage has to grow)
+    // note: if copying a value throws, the map is left untouched
+    void reserveContiguousStorage(size_type numPages)
+    {
+        if (numPages <= storage.capacity)
+        {
+            return;
+        }
 
-        numItems = other.numItems;
-        maxValidIndex = other.maxValidIndex;
+        // note: the blocks are freed by the destructor if anything below throws
+        ContiguousStorage newStorage;
+        newStorage.capacity = std::max(numPages, storage.capacity * 2);
+        newStorage.resource = getMemoryResource();
+        newStorage.values = static_cast<ValueStorage*>(newStorage.allocateBlock(ContiguousStorage::valuesSizeInBytes(newStorage.capacity)));
+        newStorage.bits = static_cast<uint64_t*>(newStorage.allocateBlock(ContiguousStorage::bitsSizeInBytes(newStorage.capacity)));
+        SLOT_MAP_ASSERT(newStorage.values && newStorage.bits);
 
-        for (size_t pageIndex = 0; pageIndex < other.pages.size(); pageIndex++)
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
         {
-            const Page& otherPage = other.pages[pageIndex];
-            if (otherPage.meta)
+            const Page& page = pages[pageIndex];
+            if (!page.isActive())
             {
-                SLOT_MAP_ASSERT(otherPage.values);
-
-                // active page
-                Page& p = pages.emplace_back();
-                p.allocate();
-                p.numInactiveSlots = otherPage.numInactiveSlots;
-                p.numUsedElements = otherPage.numUsedElements;
-
-                // copy meta
-                size_type metaSize = static_cast<size_type>(sizeof(Meta)) * kPageSize;
-                std::memcpy(p.meta, otherPage.meta, metaSize);
+                continue;
+            }
+            std::memcpy(newStorage.pageBits(static_cast<size_type>(pageIndex)), page.liveBits, sizeof(uint64_t) * kNumBitmapWords);
+            // note: raw copy keeps the free list links of tombstoned slots
+            std::memcpy(newStorage.pageValues(static_cast<size_type>(pageIndex)), page.values, sizeof(ValueStorage) * page.numUsedElements);
+        }
 
-                // copy data
-                if constexpr (std::is_standard_layout<T>::value && std::is_trivially_copyable<T>::value)
-                {
-                    size_type dataSize = static_cast<size_type>(sizeof(ValueStorage)) * kPageSize;
-                    std::memcpy(p.values, otherPage.values, dataSize);
-                }
-                else
+        if constexpr (!std::is_trivially_copyable<T>::value)
+        {
+            if constexpr (kRelocateByMove)
+            {
+                for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
                 {
-                    for (size_type elementIndex = 0; elementIndex < p.numUsedElements; elementIndex++)
+                    Page& page = pages[pageIndex];
+                    if (!page.isActive())
                     {
-                        PageAddr addr;
-                        addr.page = static_cast<size_type>(pageIndex);
-                        addr.index = elementIndex;
-
-                        const ValueStorage& otherVal = other.getValueByAddr(addr);
-                        const T* otherV = reinterpret_cast<const T*>(&otherVal);
-                        ValueStorage& val = getValueByAddr(addr);
-
-                        // copy constructor
-                        construct<T>(&val, *otherV);
+                        continue;
                     }
+                    ValueStorage* newValues = newStorage.pageValues(static_cast<size_type>(pageIndex));
+                    forEachAliveSlot(page, [&](size_type elementIndex) {
+                        T* v = reinterpret_cast<T*>(&page.valueAt(elementIndex));
+                        construct<T>(&newValues[elementIndex], std::move(*v));
+                        destruct(v);
+                        return true;
+                    });
                 }
             }
             else
             {
-                SLOT_MAP_ASSERT(otherPage.meta == nullptr);
-                SLOT_MAP_ASSERT(otherPage.values == nullptr);
+                // copy everything first, the old values are destroyed only once all the copies succeeded
+                RelocationGuard guard{pages, newStorage};
+                for (; guard.pageIndex < pages.size(); guard.pageIndex++)
+                {
+                    const Page& page = pages[guard.pageIndex];
+                    if (!page.isActive())
+                    {
+                        continue;
+                    }
+                    ValueStorage* newValues = newStorage.pageValues(static_cast<size_type>(guard.pageIndex));
+                    guard.numRelocated = 0;
+                    forEachAliveSlot(page, [&](size_type elementIndex) {
+                        construct<T>(&newValues[elementIndex], *reinterpret_cast<const T*>(&page.valueAt(elementIndex)));
+                        guard.numRelocated++;
+                        return true;
+                    });
+                }
+                guard.dismissed = true;
 
-                // inactive page
-                Page& p = pages.emplace_back();
-                p.numInactiveSlots = otherPage.numInactiveSlots;
-                p.numUsedElements = otherPage.numUsedElements;
-                SLOT_MAP_ASSERT(p.values == nullptr);
-                SLOT_MAP_ASSERT(p.meta == nullptr);
+                for (Page& page : pages)
+                {
+                    if (!page.isActive())
+                    {
+                        continue;
+                    }
+                    forEachAliveSlot(page, [&](size_type elementIndex) {
+                        destruct(reinterpret_cast<T*>(&page.valueAt(elementIndex)));
+                        return true;
+                    });
+                }
             }
         }
-    }
 
-    void callDtors()
-    {
-        size_type numItemsDestroyed = 0;
         for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
         {
             Page& page = pages[pageIndex];
-            if (page.meta == nullptr)
+            if (!page.isActive())
             {
                 continue;
             }
-            for (size_type elementIndex = 0; elementIndex < page.numUsedElements; elementIndex++)
-            {
-                PageAddr addr;
-                addr.page = static_cast<size_type>(pageIndex);
-                addr.index = static_cast<size_type>(elementIndex);
+            ValueStorage* newValues = newStorage.pageValues(static_cast<size_type>(pageIndex));
+            page.rawMemory = newValues;
+            page.values = newValues;
+            page.liveBits = newStorage.pageBits(static_cast<size_type>(pageIndex));
+        }
+        storage.swap(newStorage);
+    }
 
-                Meta& m = getMetaByAddr(addr);
-                if (m.tombstone != 0)
-                {
-                    continue;
+    // allocates memory for the new page (the page is already added to the pages)
+    void allocatePage(Page& page, size_type pageIndex)
+    {
+        if constexpr (kContiguousLayout)
+        {
+            SLOT_MAP_ASSERT(&page == &pages[pageIndex]);
+            reserveContiguousStorage(pageIndex + 1);
+            page.attach(storage.pageValues(pageIndex), storage.pageBits(pageIndex));
+        }
+        else
+        {
+            (void)pageIndex;
+            page.allocate(pageAllocator, getMemoryResource());
+        }
+    }
+
+    /*
+      Compact page table used by the lookup path (get/has_key)
+
+      One entry per page plus a trailing sentinel entry. Released pages and the sentinel point at a shared always invalid meta
+      with zero index mask, so a lookup is two dependent loads (entry, meta) and no data-dependent branches before the version compare.
+      Indices beyond the last page are clamped to the sentinel entry.
+    */
+    struct PageEntry
+    {
+        const Meta* meta;
+        size_type indexMask;
+    };
+
+    static inline constexpr Meta kInvalidMeta = {Meta::kInvalidWord};
+    static inline constexpr PageEntry kInvalidPageEntry = {&kInvalidMeta, 0};
+
+    static PageEntry makePageEntry(const Page& page) noexcept
+    {
+        return page.isActive() ? PageEntry{page.meta, kPageSize - 1} : kInvalidPageEntry;
+    }
+
+    // note: returns the always invalid meta for out of bounds indices, released pages and never used slots
+    const Meta& lookupMeta(index_t index) const noexcept
+    {
+        if constexpr (kDenseMetaLayout)
+        {
+            // dense version table has a trailing sentinel too (released pages keep their inactive meta)
+            return metaTableData[std::min(static_cast<size_type>(index), maxMetaTableIndex)];
+        }
+        else
+        {
+            const PageEntry& entry = pageTableData[std::min(static_cast<size_type>(index / kPageSize), maxPageTableIndex)];
+            return getMetaAt(entry.meta, index & entry.indexMask);
+        }
+    }
+
+    // returns the value for the meta returned by lookupMeta (confirmed hit only)
+    const ValueStorage& getValueByLookup(const Meta& m, index_t index) const noexcept
+    {
+        if constexpr (kContiguousLayout)
+        {
+            // plain offset, no page lookup
+            (void)m;
+            return storage.values[index];
+        }
+        else if constexpr (kDenseMetaLayout)
+        {
+            (void)m;
+            return getValueByAddr(getAddrFromIndex(index));
+        }
+        else
+        {
+            // note: no page lookup here, the value address is derived from the meta address
+            return getValueByMeta(m, static_cast<size_type>(index % kPageSize));
+        }
+    }
+
+    void updatePageTableView() noexcept
+    {
+        SLOT_MAP_ASSERT(pageTable.empty() || pageTable.size() == pages.size() + 1);
+        if (pageTable.empty())
+        {
+            pageTableData = &kInvalidPageEntry;
+            maxPageTableIndex = 0;
+        }
+        else
+        {
+            pageTableData = pageTable.data();
+            maxPageTableIndex = static_cast<size_type>(pageTable.size() - 1);
+        }
+
+        SLOT_MAP_ASSERT(metaTable.empty() || metaTable.size() == pages.size() * kPageSize + 1);
+        if (metaTable.empty())
+        {
+            metaTableData = &kInvalidMeta;
+            maxMetaTableIndex = 0;
+        }
+        else
+        {
+            metaTableData = metaTable.data();
+            maxMetaTableIndex = static_cast<size_type>(metaTable.size() - 1);
+        }
+    }
+
+    // registers a new page (that has just been added to the pages) in the lookup tables
+    void appendPageEntry()
+    {
+        SLOT_MAP_ASSERT(!pages.empty());
+        if constexpr (kDenseMetaLayout)
+        {
+            // the new slots never match any key, the last entry is the sentinel
+            // note: the table doubles its capacity when it grows (amortized O(1) per page, see slot_map_layout_dense_meta)
+            const size_t numMetas = pages.size() * kPageSize + 1;
+            if (numMetas > metaTable.capacity())
+            {
+                metaTable.reserve(std::max(numMetas, metaTable.capacity() * 2));
+            }
+            metaTable.resize(numMetas, kInvalidMeta);
+        }
+        else
+        {
+            if (pageTable.empty())
+            {
+                pageTable.emplace_back(kInvalidPageEntry);
+            }
+            pageTable.back() = makePageEntry(pages.back());
+            pageTable.emplace_back(kInvalidPageEntry);
+        }
+        updatePageTableView();
+    }
+
+    static inline size_type countTrailingZeros(uint64_t v) noexcept { return static_cast<size_type>(slot_map_count_trailing_zeros(v)); }
+
+    /*
+      Calls `func(elementIndex)` for every live slot of the page (in index order).
+      `func` returns false to stop the enumeration (note: `func` could erase the current slot)
+    */
+    template <typename FUNC> static void forEachAliveSlot(const Page& page, FUNC&& func)
+    {
+        for (size_type wordIndex = 0; wordIndex < kNumBitmapWords && page.numAliveSlots != 0; wordIndex++)
+        {
+            uint64_t bits = page.liveBits[wordIndex];
+            while (bits != 0)
+            {
+                size_type elementIndex = wordIndex * kBitsPerWord + countTrailingZeros(bits);
+                bits &= bits - 1;
+                if (!func(elementIndex))
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    static inline constexpr size_type align(size_type cursor, size_type alignment) noexcept { return (cursor + (alignment - 1)) & ~(alignment - 1); }
+    static inline bool isPointerAligned(void* cursor, size_t alignment) noexcept { return (uintptr_t(cursor) & (alignment - 1)) == 0; }
+
+    template <typename TYPE, class... Args> static void construct(void* mem, Args&&... args)
+    {
+        new (mem) TYPE(std::forward<Args>(args)...);
+    }
+    template <typename TYPE> void destruct(TYPE* p) { p->~T(); }
+
+    const T* getImpl(key k) const noexcept
+    {
+        index_t index = key::toIndex(k);
+        const Meta& m = lookupMeta(index);
+
+        // note: key versions never have meta marker bits set, so tombstone/inactive/sentinel slots never match
+        version_t version = getKeyWord(k);
+        if (m.word != version)
+        {
+#if defined(SLOT_MAP_INSTRUMENT)
+            // classify the miss (slow path only)
+            if (index > getMaxValidIndex())
+            {
+                SLOT_MAP_INSTRUMENT_INC(getMissesOutOfRange);
+            }
+            else if (!isActivePage(getAddrFromIndex(index)))
+            {
+                SLOT_MAP_INSTRUMENT_INC(getMissesInactivePage);
+            }
+            else
+            {
+                // version mismatch, slot has been reused (or removed)
+                SLOT_MAP_INSTRUMENT_INC(getMissesVersionMismatch);
+            }
+#endif
+            return nullptr;
+        }
+        SLOT_MAP_INSTRUMENT_INC(getHits);
+        SLOT_MAP_ASSERT(index <= getMaxValidIndex());
+        SLOT_MAP_ASSERT(isActivePage(getAddrFromIndex(index)));
+        SLOT_MAP_ASSERT(m.version() != key::kInvalidVersion);
+        SLOT_MAP_ASSERT(!m.isTombstone());
+        SLOT_MAP_ASSERT(!m.isInactive());
+
+        const ValueStorage& v = getValueByLookup(m, index);
+        SLOT_MAP_ASSERT(&v == &getValueByAddr(getAddrFromIndex(index)));
+        return reinterpret_cast<const T*>(&v);
+    }
+
+    // adds a new (empty) page to the end
+    void appendPage()
+    {
+        if constexpr (kContiguousLayout)
+        {
+            // note: grow the storage before adding the page, so a throwing relocation leaves the pages untouched
+            reserveContiguousStorage(static_cast<size_type>(pages.size()) + 1);
+        }
+        Page& p = pages.emplace_back();
+        const size_type pageIndex = static_cast<size_type>(pages.size()) - 1;
+        if (pageIndex < releasedPageWords.size())
+        {
+            // the index range has been used before (see shrink_to_fit): the versions continue above the old ones
+            p.baseWord = releasedPageWords[pageIndex];
+            p.epoch = static_cast<version_t>(p.baseWord >> key::kNumVersionBits);
+            if (pages.size() == releasedPageWords.size())
+            {
+                releasedPageWords.clear();
+            }
+        }
+        allocatePage(p, pageIndex);
+        appendPageEntry();
+        numActivePages++;
+        SLOT_MAP_INSTRUMENT_INC(pagesAllocated);
+        notifyEvent(&EventHooks::onPageAllocate, static_cast<size_type>(pages.size()) - 1, 0);
+    }
+
+    // number of never used slots (the rest of the page being filled + pages added by reserve)
+    size_type getNumUnusedSlots() const noexcept
+    {
+        size_type numUnusedSlots = 0;
+        for (size_type pageIndex = static_cast<size_type>(pages.size()); pageIndex > 0; pageIndex--)
+        {
+            const Page& page = pages[pageIndex - 1];
+            if (page.numUsedElements == kPageSize)
+            {
+                break;
+            }
+            numUnusedSlots += kPageSize - page.numUsedElements;
+        }
+        return numUnusedSlots;
+    }
+
+    index_t appendElement()
+    {
+        // pages are filled in order: the page of the last fresh index or the next one (could be already allocated by reserve)
+        size_type pageIndex = getAddrFromIndex(maxValidIndex).page;
+        if (pageIndex < pages.size() && pages[pageIndex].numUsedElements == kPageSize)
+        {
+            pageIndex++;
+        }
+        if (pageIndex == pages.size())
+        {
+            appendPage();
+        }
+
+        Page& page = pages[pageIndex];
+        SLOT_MAP_ASSERT(page.isActive());
+
+        size_type elementIndex = page.numUsedElements;
+        SLOT_MAP_ASSERT(elementIndex < kPageSize);
+        page.numUsedElements++;
+
+        Meta& m = getMetaByAddr(PageAddr{pageIndex, elementIndex});
+        m.word = page.baseWord;
+
+        index_t index = static_cast<index_t>(getIndexFromAddr(PageAddr{pageIndex, elementIndex}));
+        return index;
+    }
+
+    // removes the free indices of the pages starting from `firstPage` from the FIFO free list and the rested slot stacks
+    void removeFreeIndices(size_type firstPage) noexcept
+    {
+        index_t index = freeListHead;
+        freeListHead = kInvalidFreeIndex;
+        freeListTail = kInvalidFreeIndex;
+        numFreeIndices = 0;
+        while (index != kInvalidFreeIndex)
+        {
+            PageAddr addr = getAddrFromIndex(index);
+            index_t next = getFreeLink(addr);
+            if (addr.page < firstPage)
+            {
+                pushFreeIndex(index, addr);
+            }
+            index = next;
+        }
+
+        for (size_type pageIndex = firstPage; pageIndex < static_cast<size_type>(pages.size()); pageIndex++)
+        {
+            Page& page = pages[pageIndex];
+            if (page.numReadySlots != 0)
+            {
+                unlinkReadyPage(pageIndex);
+                numReadyIndices -= page.numReadySlots;
+                page.numReadySlots = 0;
+                page.readyHead = kInvalidFreeIndex;
+            }
+        }
+    }
+
+    /*
+      Returns the meta word the slots of a page without live values would restart from if the page is released and created again:
+      above every version the page has handed out (key::kInvalidVersion if there is no such word).
+      Every slot restarts from the same word (one word per released page is recorded, see shrink_to_fit).
+    */
+    version_t getReleasedPageWord(size_type pageIndex) const noexcept
+    {
+        const Page& page = pages[pageIndex];
+        SLOT_MAP_ASSERT(page.numAliveSlots == 0);
+        if (page.numInactiveSlots == 0)
+        {
+            // note: tombstones hold the next (not yet handed out) version
+            version_t word = page.baseWord;
+            for (size_type elementIndex = 0; elementIndex < page.numUsedElements; elementIndex++)
+            {
+                word = std::max(word, getMetaByAddr(PageAddr{pageIndex, elementIndex}).version());
+            }
+            return word;
+        }
+        // some versions are exhausted: the next page epoch is required
+        if (page.epoch == key::kMaxEpoch)
+        {
+            return key::kInvalidVersion;
+        }
+        return static_cast<version_t>(key::kMinVersion | ((page.epoch + 1) << key::kNumVersionBits));
+    }
+
+    struct PageAddr
+    {
+        size_type page;
+        size_type index;
+    };
+
+    template <typename INTEGRAL_TYPE> inline static constexpr bool isPow2(INTEGRAL_TYPE x) noexcept
+    {
+        static_assert(std::is_integral<INTEGRAL_TYPE>::value, "isPow2 must be called on an integer type.");
+        return (x & (x - 1)) == 0 && (x != 0);
+    }
+
+    static inline PageAddr getAddrFromIndex(size_type index) noexcept
+    {
+        static_assert(isPow2(kPageSize), "kPageSize is expected to be a power of two.");
+        PageAddr res;
+        res.page = index / kPageSize;
+        res.index = index % kPageSize;
+        return res;
+    }
+
+    // to global index
+    static inline index_t getIndexFromAddr(PageAddr addr) noexcept
+    {
+        size_type index = (addr.page * kPageSize + addr.index);
+        return index_t(index);
+    }
+
+    const Meta& getMetaByAddrImpl(PageAddr addr) const noexcept
+    {
+        SLOT_MAP_ASSERT(addr.page < pages.size());
+        const Page& page = pages[addr.page];
+        SLOT_MAP_ASSERT(page.isActive());
+        SLOT_MAP_ASSERT(addr.index < kPageSize);
+        if constexpr (kDenseMetaLayout)
+        {
+            return metaTable[getIndexFromAddr(addr)];
+        }
+        else
+        {
+            return page.metaAt(addr.index);
+        }
+    }
+
+    const ValueStorage& getValueByAddrImpl(PageAddr addr) const noexcept
+    {
+        SLOT_MAP_ASSERT(addr.page < pages.size());
+        const Page& page = pages[addr.page];
+        SLOT_MAP_ASSERT(page.values);
+        SLOT_MAP_ASSERT(addr.index < kPageSize);
+        return page.valueAt(addr.index);
+    }
+
+    const Meta& getMetaByAddr(PageAddr addr) const noexcept { return getMetaByAddrImpl(addr); }
+    const ValueStorage& getValueByAddr(PageAddr addr) const noexcept { return getValueByAddrImpl(addr); }
+
+    Meta& getMetaByAddr(PageAddr addr) noexcept
+    {
+        const Meta& constRes = getMetaByAddrImpl(addr);
+        return const_cast<Meta&>(constRes);
+    }
+
+    ValueStorage& getValueByAddr(PageAddr addr) noexcept
+    {
+        const ValueStorage& constRes = getValueByAddrImpl(addr);
+        return const_cast<ValueStorage&>(constRes);
+    }
+
+    // returns the index of the first live slot starting from `index` (or getMaxValidIndex() + 1 if there are no live slots left)
+    size_type findNextAlive(size_type index) const noexcept
+    {
+        const size_type endIndex = getMaxValidIndex() + static_cast<size_type>(1);
+        if (numItems == 0)
+        {
+            return endIndex;
+        }
+
+        PageAddr addr = getAddrFromIndex(index);
+        while (addr.page < pages.size())
+        {
+            const Page& page = pages[addr.page];
+            // inactive pages have no live slots
+            if (page.numAliveSlots != 0)
+            {
+                size_type wordIndex = addr.index / kBitsPerWord;
+                uint64_t bits = page.liveBits[wordIndex] & (~uint64_t(0) << (addr.index % kBitsPerWord));
+                while (true)
+                {
+                    if (bits != 0)
+                    {
+                        return getIndexFromAddr(PageAddr{addr.page, wordIndex * kBitsPerWord + countTrailingZeros(bits)});
+                    }
+                    wordIndex++;
+                    if (wordIndex == kNumBitmapWords)
+                    {
+                        break;
+                    }
+                    bits = page.liveBits[wordIndex];
                 }
-                if constexpr (!std::is_trivially_destructible<T>::value)
+            }
+            addr.page++;
+            addr.index = 0;
+        }
+        return endIndex;
+    }
+
+    bool isActivePage(PageAddr addr) const noexcept
+    {
+        if (addr.page >= pages.size())
+        {
+            return false;
+        }
+        const Page& page = pages[addr.page];
+        return page.isActive();
+    }
+
+    size_type getMaxValidIndex() const noexcept { return maxValidIndex; }
+
+    // all the containers share the same memory resource (see slot_map(std::pmr::memory_resource*))
+    std::pmr::memory_resource* getMemoryResource() const noexcept { return pages.get_allocator().resource(); }
+
+    void copyFrom(const slot_map& other)
+    {
+        resetImpl();
+
+        SLOT_MAP_ASSERT(numItems == 0);
+        SLOT_MAP_ASSERT(maxValidIndex == 0);
+        SLOT_MAP_ASSERT(pages.empty());
+        SLOT_MAP_ASSERT(numFreeIndices == 0);
+
+        static_assert(std::is_standard_layout<Meta>::value && std::is_trivially_copyable<Meta>::value,
+                      "Meta is expected to be memcopyable (POD type)");
+
+        numItems = other.numItems;
+        maxValidIndex = other.maxValidIndex;
+        numTombstoneItems = other.numTombstoneItems;
+        numInactiveItems = other.numInactiveItems;
+        numActivePages = other.numActivePages;
+        numInactivePages = other.numInactivePages;
+
+        if constexpr (kContiguousLayout)
+        {
+            reserveContiguousStorage(static_cast<size_type>(other.pages.size()));
+        }
+
+        for (size_t pageIndex = 0; pageIndex < other.pages.size(); pageIndex++)
+        {
+            const Page& otherPage = other.pages[pageIndex];
+            if (otherPage.isActive())
+            {
+                SLOT_MAP_ASSERT(otherPage.values);
+
+                // active page
+                Page& p = pages.emplace_back();
+                allocatePage(p, static_cast<size_type>(pageIndex));
+                SLOT_MAP_INSTRUMENT_INC(pagesAllocated);
+                notifyEvent(&EventHooks::onPageAllocate, static_cast<size_type>(pageIndex), 0);
+                p.numInactiveSlots = otherPage.numInactiveSlots;
+                p.numUsedElements = otherPage.numUsedElements;
+                p.numAliveSlots = otherPage.numAliveSlots;
+                p.readyHead = otherPage.readyHead;
+                p.numReadySlots = otherPage.numReadySlots;
+                p.readyBucket = otherPage.readyBucket;
+                p.prevReadyPage = otherPage.prevReadyPage;
+                p.nextReadyPage = otherPage.nextReadyPage;
+                p.epoch = otherPage.epoch;
+                p.baseWord = otherPage.baseWord;
+
+                const PageLayout& layout = kPageLayout;
+                if constexpr (kContiguousLayout && std::is_standard_layout<T>::value && std::is_trivially_copyable<T>::value)
+                {
+                    // values and live slots bitmap are stored in separate arrays
+                    std::memcpy(p.values, otherPage.values, layout.dataSize);
+                    std::memcpy(p.liveBits, otherPage.liveBits, layout.bitmapSize);
+                }
+                else if constexpr (std::is_standard_layout<T>::value && std::is_trivially_copyable<T>::value)
                 {
-                    ValueStorage& v = getValueByAddr(addr);
-                    destruct(reinterpret_cast<const T*>(&v));
+                    // copy the whole page (values, meta and live slots bitmap)
+                    std::memcpy(p.rawMemory, otherPage.rawMemory, layout.numBytes);
                 }
-                numItemsDestroyed++;
+                else
+                {
+                    // copy meta and live slots bitmap
+                    if constexpr (kInterleavedLayout)
+                    {
+                        for (size_type elementIndex = 0; elementIndex < kPageSize; elementIndex++)
+                        {
+                            p.metaAt(elementIndex) = otherPage.metaAt(elementIndex);
+                        }
+                    }
+                    else if constexpr (!kDenseMetaLayout)
+                    {
+                        std::memcpy(p.meta, otherPage.meta, layout.metaSize);
+                    }
+                    std::memcpy(p.liveBits, otherPage.liveBits, layout.bitmapSize);
+
+                    // copy live values only
+                    forEachAliveSlot(otherPage, [&](size_type elementIndex) {
+                        const T* otherV = reinterpret_cast<const T*>(&otherPage.valueAt(elementIndex));
+                        // copy constructor
+                        construct<T>(&p.valueAt(elementIndex), *otherV);
+                        return true;
+                    });
+                }
+            }
+            else
+            {
+                SLOT_MAP_ASSERT(!otherPage.isActive());
+                SLOT_MAP_ASSERT(otherPage.values == nullptr);
+
+                // inactive page
+                Page& p = pages.emplace_back();
+                p.numInactiveSlots = otherPage.numInactiveSlots;
+                p.numUsedElements = otherPage.numUsedElements;
+                p.epoch = otherPage.epoch;
+                p.baseWord = otherPage.baseWord;
+                SLOT_MAP_ASSERT(p.values == nullptr);
+                SLOT_MAP_ASSERT(p.meta == nullptr);
+            }
+            if constexpr (!kDenseMetaLayout)
+            {
+                appendPageEntry();
+            }
+        }
+
+        if constexpr (kDenseMetaLayout)
+        {
+            // copy the whole version table at once
+            metaTable = other.metaTable;
+            updatePageTableView();
+        }
+        releasedPageWords = other.releasedPageWords;
+
+        // copy the free list links (values of tombstoned slots are not copied for non trivially copyable types)
+        for (index_t index = other.freeListHead; index != kInvalidFreeIndex; index = other.getFreeLink(other.getAddrFromIndex(index)))
+        {
+            setFreeLink(getAddrFromIndex(index), other.getFreeLink(other.getAddrFromIndex(index)));
+        }
+        freeListHead = other.freeListHead;
+        freeListTail = other.freeListTail;
+        numFreeIndices = other.numFreeIndices;
+
+        // copy the page-local reuse stacks (the bucket lists are copied with the pages)
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            for (index_t index = pages[pageIndex].readyHead; index != kInvalidFreeIndex; index = other.getFreeLink(other.getAddrFromIndex(index)))
+            {
+                setFreeLink(getAddrFromIndex(index), other.getFreeLink(other.getAddrFromIndex(index)));
+            }
+        }
+        std::copy(std::begin(other.readyBuckets), std::end(other.readyBuckets), std::begin(readyBuckets));
+        numReadyIndices = other.numReadyIndices;
+        reusePolicy = other.reusePolicy;
+        reuseThreshold = other.reuseThreshold;
+    }
+
+    /*
+      Intrusive FIFO free list
+
+      Recycled slots are linked through the dead value storage of tombstoned slots (no extra memory, no allocations on erase/emplace).
+      The key of a recycled slot is restored from the slot index and the version stored in the tombstone.
+    */
+    index_t getFreeLink(PageAddr addr) const noexcept
+    {
+        index_t next;
+        std::memcpy(&next, &getValueByAddr(addr), sizeof(index_t));
+        return next;
+    }
+
+    void setFreeLink(PageAddr addr, index_t next) noexcept { std::memcpy(&getValueByAddr(addr), &next, sizeof(index_t)); }
+
+    void pushFreeIndex(index_t index, PageAddr addr) noexcept
+    {
+        SLOT_MAP_ASSERT(index != kInvalidFreeIndex);
+        setFreeLink(addr, kInvalidFreeIndex);
+        if (freeListTail == kInvalidFreeIndex)
+        {
+            freeListHead = index;
+        }
+        else
+        {
+            setFreeLink(getAddrFromIndex(freeListTail), index);
+        }
+        freeListTail = index;
+        numFreeIndices++;
+    }
+
+    index_t popFreeIndex() noexcept
+    {
+        SLOT_MAP_ASSERT(numFreeIndices > 0 && freeListHead != kInvalidFreeIndex);
+        index_t index = freeListHead;
+        freeListHead = getFreeLink(getAddrFromIndex(index));
+        if (freeListHead == kInvalidFreeIndex)
+        {
+            freeListTail = kInvalidFreeIndex;
+        }
+        numFreeIndices--;
+        return index;
+    }
+
+    /*
+      dense_first reuse policy
+
+      Slots that rested in the FIFO free list for the reuse threshold (kMinFreeIndices) erases are moved to page-local stacks (rested slots).
+      Pages with rested slots are kept in kNumReuseBuckets occupancy buckets, emplace takes a slot from the densest bucket, so the
+      densest pages are refilled first and sparse pages drain. Bucket updates are O(1) (doubly linked list of pages per bucket).
+    */
+    static size_type getReuseBucket(size_type numAliveSlots) noexcept
+    {
+        // note: a page with rested slots is never full
+        SLOT_MAP_ASSERT(numAliveSlots < kPageSize);
+        return static_cast<size_type>((static_cast<uint64_t>(numAliveSlots) * kNumReuseBuckets) / kPageSize);
+    }
+
+    void linkReadyPage(size_type pageIndex) noexcept
+    {
+        Page& page = pages[pageIndex];
+        page.readyBucket = getReuseBucket(page.numAliveSlots);
+        page.prevReadyPage = kInvalidPageIndex;
+        page.nextReadyPage = readyBuckets[page.readyBucket];
+        if (page.nextReadyPage != kInvalidPageIndex)
+        {
+            pages[page.nextReadyPage].prevReadyPage = pageIndex;
+        }
+        readyBuckets[page.readyBucket] = pageIndex;
+    }
+
+    void unlinkReadyPage(size_type pageIndex) noexcept
+    {
+        Page& page = pages[pageIndex];
+        if (page.prevReadyPage != kInvalidPageIndex)
+        {
+            pages[page.prevReadyPage].nextReadyPage = page.nextReadyPage;
+        }
+        else
+        {
+            SLOT_MAP_ASSERT(readyBuckets[page.readyBucket] == pageIndex);
+            readyBuckets[page.readyBucket] = page.nextReadyPage;
+        }
+        if (page.nextReadyPage != kInvalidPageIndex)
+        {
+            pages[page.nextReadyPage].prevReadyPage = page.prevReadyPage;
+        }
+        page.prevReadyPage = kInvalidPageIndex;
+        page.nextReadyPage = kInvalidPageIndex;
+    }
+
+    // must be called after the number of alive slots of the page has changed
+    void updateReadyPage(size_type pageIndex) noexcept
+    {
+        const Page& page = pages[pageIndex];
+        if (page.numReadySlots != 0 && page.readyBucket != getReuseBucket(page.numAliveSlots))
+        {
+            unlinkReadyPage(pageIndex);
+            linkReadyPage(pageIndex);
+        }
+    }
+
+    void pushReadyIndex(index_t index) noexcept
+    {
+        PageAddr addr = getAddrFromIndex(index);
+        Page& page = pages[addr.page];
+        setFreeLink(addr, page.readyHead);
+        page.readyHead = index;
+        page.numReadySlots++;
+        if (page.numReadySlots == 1)
+        {
+            linkReadyPage(addr.page);
+        }
+        numReadyIndices++;
+    }
+
+    index_t popReadyIndex() noexcept
+    {
+        SLOT_MAP_ASSERT(numReadyIndices > 0);
+        for (size_type bucket = kNumReuseBuckets; bucket > 0; bucket--)
+        {
+            size_type pageIndex = readyBuckets[bucket - 1];
+            if (pageIndex == kInvalidPageIndex)
+            {
+                continue;
+            }
+            Page& page = pages[pageIndex];
+            index_t index = page.readyHead;
+            page.readyHead = getFreeLink(getAddrFromIndex(index));
+            page.numReadySlots--;
+            if (page.numReadySlots == 0)
+            {
+                unlinkReadyPage(pageIndex);
+            }
+            numReadyIndices--;
+            return index;
+        }
+        SLOT_MAP_ASSERT(false);
+        return kInvalidFreeIndex;
+    }
+
+    void setReuseThreshold(size_type value) noexcept
+    {
+        reuseThreshold.value = value;
+        reuseThreshold.numErases = 0;
+        reuseThreshold.numDeactivations = 0;
+        reuseThreshold.versionSum = 0;
+        if (reusePolicy == slot_map_reuse_policy::dense_first)
+        {
+            drainRestedIndices();
+        }
+    }
+
+    // dense_first reuse policy: moves the slots that rested long enough from the FIFO list to the page-local stacks
+    void drainRestedIndices() noexcept
+    {
+        while (numFreeIndices > reuseThreshold.value)
+        {
+            pushReadyIndex(popFreeIndex());
+        }
+    }
+
+    /*
+      Reuse threshold (MINFREEINDICES) state
+
+      In adaptive mode the threshold is updated every kAdaptiveWindow erases (see adaptReuseThreshold).
+    */
+    struct ReuseThreshold
+    {
+        // current threshold
+        size_type value = kMinFreeIndices;
+        // adaptive mode bounds
+        size_type minValue = kMinFreeIndices;
+        size_type maxValue = kMinFreeIndices;
+        bool adaptive = false;
+
+        // current measurement window
+        size_type numErases = 0;
+        size_type numDeactivations = 0;
+        uint64_t versionSum = 0;
+    };
+
+    void observeErase(version_t slotVersion, bool deactivateSlot) noexcept
+    {
+        reuseThreshold.numErases++;
+        reuseThreshold.numDeactivations += deactivateSlot ? 1 : 0;
+        reuseThreshold.versionSum += slotVersion;
+        if (reuseThreshold.numErases == kAdaptiveWindow)
+        {
+            adaptReuseThreshold();
+        }
+    }
+
+    /*
+      Version pressure: slots deactivated in the window or the average version of the erased slots is close to kMaxVersion.
+      Churn: the window's erases turned over the whole live population (bursty spawn/despawn) or not (steady state).
+
+      - grow (x2) if slots were retired, versions are past kMaxVersion / 2, or churn is high and versions are past kMaxVersion / 8
+      - shrink (/2) if churn is low and versions are below kMaxVersion / 8 (the resting slots only cost memory)
+    */
+    void adaptReuseThreshold() noexcept
+    {
+        const uint64_t avgVersion = reuseThreshold.versionSum / reuseThreshold.numErases;
+        const bool highChurn = numItems < reuseThreshold.numErases;
+        const bool grow = reuseThreshold.numDeactivations != 0 || avgVersion > key::kMaxVersion / 2 ||
+                          (highChurn && avgVersion > key::kMaxVersion / 8);
+        const bool shrink = !grow && !highChurn && avgVersion < key::kMaxVersion / 8;
+
+        size_type value = reuseThreshold.value;
+        if (grow)
+        {
+            // note: value * 2 could wrap around for large bounds
+            value = (value > reuseThreshold.maxValue / 2) ? reuseThreshold.maxValue : std::max(value * 2, size_type(1));
+        }
+        else if (shrink)
+        {
+            value = std::max(value / 2, reuseThreshold.minValue);
+        }
+        // note: also starts a new measurement window
+        setReuseThreshold(value);
+    }
+
+    void callDtors()
+    {
+        size_type numItemsDestroyed = 0;
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            Page& page = pages[pageIndex];
+            if constexpr (!std::is_trivially_destructible<T>::value)
+            {
+                forEachAliveSlot(page, [&](size_type elementIndex) {
+                    destruct(reinterpret_cast<const T*>(&page.valueAt(elementIndex)));
+                    return true;
+                });
             }
+            numItemsDestroyed += page.numAliveSlots;
         }
         SLOT_MAP_ASSERT(numItemsDestroyed == numItems);
+        (void)numItemsDestroyed;
     }
 
     enum class EraseResult
@@ -759,6 +2312,46 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
         ErasedAndPageDeactivated,
     };
 
+    static const char* getTypeName() noexcept
+    {
+#if defined(_MSC_VER)
+        return __FUNCSIG__;
+#else
+        return __PRETTY_FUNCTION__;
+#endif
+    }
+
+    void notifyEvent(EventCallback EventHooks::*callback, size_type pageIndex, size_type slotIndex) const
+    {
+        if (eventHooks == nullptr || (eventHooks->*callback) == nullptr)
+        {
+            return;
+        }
+        EventInfo info;
+        info.slotMap = this;
+        info.typeName = getTypeName();
+        info.pageIndex = pageIndex;
+        info.slotIndex = slotIndex;
+        info.sizeInBytes = kPageLayout.numBytes;
+        (eventHooks->*callback)(info, eventHooks->userData);
+    }
+
+    // notify that all the active pages are about to be released
+    void notifyAllPagesReleased() const
+    {
+        if (eventHooks == nullptr || eventHooks->onPageRelease == nullptr)
+        {
+            return;
+        }
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            if (pages[pageIndex].isActive())
+            {
+                notifyEvent(&EventHooks::onPageRelease, static_cast<size_type>(pageIndex), 0);
+            }
+        }
+    }
+
     template <bool VERSION_CHECK> EraseResult eraseImpl(key k)
     {
         index_t index = key::toIndex(k);
@@ -774,91 +2367,415 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
         }
 
         Meta& m = getMetaByAddr(addr);
-        if (m.tombstone != 0)
+        if (m.isTombstone())
         {
             return EraseResult::NotFound;
         }
 
-        version_t slotVersion = m.version;
+        version_t slotVersion = m.word;
 
         if constexpr (VERSION_CHECK)
         {
-            version_t version = key::toVersion(k);
-            if (slotVersion != version || slotVersion == key::kInvalidVersion || version == key::kInvalidVersion)
+            version_t version = getKeyWord(k);
+            if (slotVersion != version || slotVersion == key::kInvalidVersion || key::toVersion(k) == key::kInvalidVersion)
             {
                 return EraseResult::NotFound;
             }
         }
 
-        bool deactivateSlot = (slotVersion == key::kMaxVersion);
+        // note: the page epoch (if any) is stored above the version and doesn't change here
+        bool deactivateSlot = ((slotVersion & key::kMaxVersion) == key::kMaxVersion);
+        if (reuseThreshold.adaptive)
+        {
+            observeErase(static_cast<version_t>(slotVersion & key::kMaxVersion), deactivateSlot);
+        }
         if (deactivateSlot)
         {
             // version overflow = deactivate slot
-            m.inactive = 1;
+            m.word = static_cast<version_t>(slotVersion | Meta::kTombstoneBit | Meta::kInactiveBit);
+            SLOT_MAP_INSTRUMENT_INC(slotsDeactivated);
+            notifyEvent(&EventHooks::onSlotDeactivate, addr.page, addr.index);
         }
         else
         {
             // increase version
             slotVersion = key::increaseVersion(slotVersion);
             SLOT_MAP_ASSERT(slotVersion != key::kInvalidVersion);
-            SLOT_MAP_ASSERT(slotVersion > m.version);
+            SLOT_MAP_ASSERT(slotVersion > m.version());
+            m.word = static_cast<version_t>(slotVersion | Meta::kTombstoneBit);
+        }
+
+        pages[addr.page].setDead(addr.index);
+        updateReadyPage(addr.page);
+        if (deactivateSlot)
+        {
+            numInactiveItems++;
+        }
+        else
+        {
+            numTombstoneItems++;
+        }
+
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            ValueStorage& v = getValueByAddr(addr);
+            const T* pv = reinterpret_cast<const T*>(&v);
+            destruct(pv);
+        }
+        numItems--;
+
+        if (deactivateSlot)
+        {
+            Page& page = pages[addr.page];
+            page.numInactiveSlots++;
+            if (page.numInactiveSlots == kPageSize)
+            {
+                page.deallocate();
+                if constexpr (!kDenseMetaLayout)
+                {
+                    pageTable[addr.page] = kInvalidPageEntry;
+                }
+                SLOT_MAP_INSTRUMENT_INC(pagesFreed);
+                notifyEvent(&EventHooks::onPageRelease, addr.page, 0);
+                numInactiveItems -= kPageSize;
+                numActivePages--;
+                numInactivePages++;
+                return EraseResult::ErasedAndPageDeactivated;
+            }
+        }
+        else
+        {
+            // recycle index id
+            pushFreeIndex(key::toIndex(k), addr);
+            if (reusePolicy == slot_map_reuse_policy::dense_first && numFreeIndices > reuseThreshold.value)
+            {
+                // the oldest slot has rested long enough
+                pushReadyIndex(popFreeIndex());
+            }
+            SLOT_MAP_INSTRUMENT_MAX(freeIndicesHighWaterMark, numFreeIndices + numReadyIndices);
+        }
+        return EraseResult::ErasedAndIndexRecycled;
+    }
+
+    void resetImpl()
+    {
+        callDtors();
+        SLOT_MAP_INSTRUMENT_ADD(pagesFreed, numActivePages);
+        notifyAllPagesReleased();
+
+        numItems = 0;
+        maxValidIndex = 0;
+        numTombstoneItems = 0;
+        numInactiveItems = 0;
+        numActivePages = 0;
+        numInactivePages = 0;
+
+        // Release used memory (using swap trick)
+        if (!pages.empty())
+        {
+            // note: the temporaries share the memory resource (allocators propagate on swap)
+            std::vector<Page, stl::Allocator<Page>> tmpPages(pages.get_allocator());
+            pages.swap(tmpPages);
+            std::vector<PageEntry, stl::Allocator<PageEntry>> tmpPageTable(pageTable.get_allocator());
+            pageTable.swap(tmpPageTable);
+            std::vector<Meta, stl::Allocator<Meta>> tmpMetaTable(metaTable.get_allocator());
+            metaTable.swap(tmpMetaTable);
+            updatePageTableView();
+            storage.release();
+        }
+        std::vector<version_t, stl::Allocator<version_t>> tmpReleasedPageWords(releasedPageWords.get_allocator());
+        releasedPageWords.swap(tmpReleasedPageWords);
+
+        freeListHead = kInvalidFreeIndex;
+        freeListTail = kInvalidFreeIndex;
+        numFreeIndices = 0;
+        std::fill(std::begin(readyBuckets), std::end(readyBuckets), kInvalidPageIndex);
+        numReadyIndices = 0;
+    }
+
+    void clearImpl()
+    {
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            const Page& page = pages[pageIndex];
+            forEachAliveSlot(page, [&](size_type elementIndex) {
+                index_t index = getIndexFromAddr(PageAddr{static_cast<size_type>(pageIndex), elementIndex});
+                // note: version doesn't matter here
+                EraseResult res = eraseImpl<false>(key::make(key::kMinVersion, index));
+                SLOT_MAP_ASSERT(res != EraseResult::NotFound);
+                // noting left on this page - go to the next page
+                return (res != EraseResult::ErasedAndPageDeactivated);
+            });
+        }
+        SLOT_MAP_ASSERT(numItems == 0);
+    }
+
+    template <class... Args> key emplaceImpl(Args&&... args)
+    {
+        // Use recycled IDs only if we accumulated enough of them
+        // note: the dense_first policy keeps at most reuseThreshold.value slots in the FIFO list (the rest are rested slots)
+        if (numFreeIndices + numReadyIndices > reuseThreshold.value)
+        {
+            index_t index = (numReadyIndices != 0) ? popReadyIndex() : popFreeIndex();
+            SLOT_MAP_ASSERT(index <= getMaxValidIndex());
+
+            PageAddr addr = getAddrFromIndex(index);
+            Meta& m = getMetaByAddr(addr);
+            SLOT_MAP_ASSERT(!m.isInactive());
+            SLOT_MAP_ASSERT(m.isTombstone());
+
+            // note: the tombstone already holds the increased version (tag is not saved!)
+            m.word = m.version();
+            key k = makeKey(m.word, index);
+            numTombstoneItems--;
+
+            ValueStorage& v = getValueByAddr(addr);
+            construct<T>(&v, std::forward<Args>(args)...);
+            pages[addr.page].setAlive(addr.index);
+            updateReadyPage(addr.page);
+            numItems++;
+            SLOT_MAP_INSTRUMENT_INC(emplaceRecycled);
+            return k;
+        }
+
+        // allocate new item
+        index_t index = appendElement();
+        maxValidIndex = std::max(maxValidIndex, index);
+
+        PageAddr addr = getAddrFromIndex(index);
+        const Meta& m = getMetaByAddr(addr);
+        SLOT_MAP_ASSERT(!m.isTombstone());
+
+        ValueStorage& v = getValueByAddr(addr);
+        construct<T>(&v, std::forward<Args>(args)...);
+        pages[addr.page].setAlive(addr.index);
+        updateReadyPage(addr.page);
+        numItems++;
+        SLOT_MAP_INSTRUMENT_INC(emplaceFresh);
+        key k = makeKey(m.word, index);
+        return k;
+    }
+
+  public:
+    slot_map()
+        : slot_map(nullptr)
+    {
+    }
+
+    /*
+      Constructs an empty slot map that allocates all its memory (pages, page table, version table)
+      from the given memory resource (nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE), e.g. a per-frame arena or a std::pmr::monotonic_buffer_resource.
+      Note: the resource must outlive the slot map. The resource follows the content on move/swap and is inherited by the copy constructor.
+      Copy assignment keeps the resource of the destination: the copied pages are allocated from the destination's resource, not the source's.
+      A page allocator (see set_page_allocator) takes precedence for page memory.
+    */
+    explicit slot_map(std::pmr::memory_resource* resource)
+        : pages(stl::Allocator<Page>(resource))
+        , pageTable(stl::Allocator<PageEntry>(resource))
+        , pageTableData(&kInvalidPageEntry)
+        , maxPageTableIndex(0)
+        , metaTable(stl::Allocator<Meta>(resource))
+        , metaTableData(&kInvalidMeta)
+        , maxMetaTableIndex(0)
+        , releasedPageWords(stl::Allocator<version_t>(resource))
+        , freeListHead(kInvalidFreeIndex)
+        , freeListTail(kInvalidFreeIndex)
+        , numFreeIndices(0)
+        , numReadyIndices(0)
+        , reusePolicy(slot_map_reuse_policy::fifo)
+        , numItems(0)
+        , maxValidIndex(0)
+        , numTombstoneItems(0)
+        , numInactiveItems(0)
+        , numActivePages(0)
+        , numInactivePages(0)
+        , eventHooks(nullptr)
+        , pageAllocator(nullptr)
+#if defined(SLOT_MAP_TRACE)
+        , traceRecorder(nullptr)
+#endif
+    {
+        std::fill(std::begin(readyBuckets), std::end(readyBuckets), kInvalidPageIndex);
+    }
+    ~slot_map()
+    {
+        callDtors();
+        notifyAllPagesReleased();
+    }
+
+    /*
+      Sets page allocation/release and slot deactivation event hooks for this instance (nullptr to disable)
+      Useful to attribute memory spikes and allocation latency to a specific slot map instance in external profilers.
+      Note: the hooks object must outlive the slot map (or be unset). Hooks follow the content on move/swap and are inherited by the copy constructor
+      (copy assignment keeps the hooks of the destination).
+    */
+    void set_event_hooks(const EventHooks* hooks) noexcept { eventHooks = hooks; }
+    const EventHooks* get_event_hooks() const noexcept { return eventHooks; }
+
+    /*
+      Sets the allocator for new pages (nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE), e.g. a slot_map_page_pool shared by several slot maps.
+      Pages that are already allocated are returned to the allocator they were allocated from.
+      Note: the allocator must outlive all the pages allocated from it. The allocator follows the content on move/swap and is inherited by the
+      copy constructor. Copy assignment keeps the allocator of the destination: the copied pages are allocated from the destination's allocator.
+      Note: the contiguous layout storage doesn't use page allocators.
+    */
+    void set_page_allocator(slot_map_page_allocator* allocator) noexcept { pageAllocator = allocator; }
+    slot_map_page_allocator* get_page_allocator() const noexcept { return pageAllocator; }
+
+    /*
+      Sets the free slot reuse policy (see slot_map_reuse_policy), the default is slot_map_reuse_policy::fifo.
+      The policy could be changed at any time, the already rested slots are kept. The policy is copied with the content.
+      Note: O(n) complexity (n = number of recycled slots)
+    */
+    void set_reuse_policy(slot_map_reuse_policy policy) noexcept
+    {
+        if (policy == reusePolicy)
+        {
+            return;
+        }
+        reusePolicy = policy;
+        if (policy == slot_map_reuse_policy::dense_first)
+        {
+            drainRestedIndices();
+            return;
+        }
+
+        // rested slots go to the front of the FIFO list (they are older than the slots in the list)
+        while (numReadyIndices != 0)
+        {
+            index_t index = popReadyIndex();
+            setFreeLink(getAddrFromIndex(index), freeListHead);
+            freeListHead = index;
+            if (freeListTail == kInvalidFreeIndex)
+            {
+                freeListTail = index;
+            }
+            numFreeIndices++;
         }
+    }
+
+    slot_map_reuse_policy get_reuse_policy() const noexcept { return reusePolicy; }
+
+    /*
+      Enables runtime-adaptive reuse threshold (MINFREEINDICES) within [minValue, maxValue].
+
+      The map measures its churn (erases vs. live items) and how close the versions of the erased slots are to kMaxVersion
+      every kAdaptiveWindow erases, and doubles the threshold when slots get close to retirement (version overflow)
+      or halves it in steady state (fewer resting slots = less memory). The threshold starts at kMinFreeIndices (clamped to the bounds).
+      The settings are copied with the content.
+    */
+    void enable_adaptive_min_free_indices(size_type minValue, size_type maxValue) noexcept
+    {
+        SLOT_MAP_ASSERT(minValue <= maxValue);
+        reuseThreshold.adaptive = true;
+        reuseThreshold.minValue = minValue;
+        reuseThreshold.maxValue = maxValue;
+        setReuseThreshold(std::min(std::max(reuseThreshold.value, minValue), maxValue));
+    }
 
-        m.version = slotVersion;
-        m.tombstone = 1;
+    /*
+      Disables adaptive mode (the threshold goes back to kMinFreeIndices)
+    */
+    void disable_adaptive_min_free_indices() noexcept
+    {
+        reuseThreshold.adaptive = false;
+        reuseThreshold.minValue = kMinFreeIndices;
+        reuseThreshold.maxValue = kMinFreeIndices;
+        setReuseThreshold(kMinFreeIndices);
+    }
 
-        if constexpr (!std::is_trivially_destructible<T>::value)
-        {
-            ValueStorage& v = getValueByAddr(addr);
-            const T* pv = reinterpret_cast<const T*>(&v);
-            destruct(pv);
-        }
-        numItems--;
+    /*
+      Returns the current reuse threshold (kMinFreeIndices unless adaptive mode is enabled)
+    */
+    size_type get_min_free_indices() const noexcept { return reuseThreshold.value; }
 
-        if (deactivateSlot)
+    /*
+      Makes the index space of the retired pages (every slot deactivated because of version overflow) usable again.
+      Returns the number of reclaimed pages.
+
+      A retired page has handed out every version of every slot, so its slots can only be reused with keys that differ
+      in something else: every reclaim bumps the page epoch, which is encoded into the keys (slot_map_key32_epoch / slot_map_key64_epoch,
+      the epoch takes the tag bits, the index range stays the same). Keys issued before the reclaim carry an older epoch and never match again
+      (no key collisions). A page can be reclaimed key::kMaxEpoch times, after that it stays retired. So every slot index hands out up to
+      (kMaxEpoch + 1) * kMaxVersion keys instead of kMaxVersion: 4 * 1023 with slot_map_key32_epoch, 1024 * 1M with slot_map_key64_epoch.
+      Note: the index space is still bounded by the total churn (fixed-width keys can't hand out an unlimited number of distinct keys),
+      reclaiming multiplies the churn it takes by 2^EPOCH_BITS.
+      Does nothing for keys without epoch bits (slot_map_key32, slot_map_key64).
+
+      Reclaimed slots restart at kMinVersion (in the new epoch) and are queued as free indices (memory for the pages is allocated here,
+      the free list lives in the slot storage). Keys of the live values are not affected.
+    */
+    size_type reclaim_inactive_pages()
+    {
+        size_type numReclaimed = 0;
+        for (size_type pageIndex = 0; pageIndex < static_cast<size_type>(pages.size()) && numInactivePages != 0; pageIndex++)
         {
-            Page& page = pages[addr.page];
-            page.numInactiveSlots++;
-            if (page.numInactiveSlots == kPageSize)
+            Page& page = pages[pageIndex];
+            if (page.isActive() || page.epoch == key::kMaxEpoch)
             {
-                page.deallocate();
-                return EraseResult::ErasedAndPageDeactivated;
+                continue;
+            }
+            SLOT_MAP_ASSERT(page.numInactiveSlots == kPageSize && page.numUsedElements == kPageSize);
+
+            allocatePage(page, pageIndex);
+            page.numUsedElements = kPageSize;
+            page.epoch++;
+            if constexpr (!kDenseMetaLayout)
+            {
+                pageTable[pageIndex] = makePageEntry(page);
+            }
+            const version_t word = static_cast<version_t>(key::kMinVersion | (page.epoch << key::kNumVersionBits) | Meta::kTombstoneBit);
+            for (size_type elementIndex = 0; elementIndex < kPageSize; elementIndex++)
+            {
+                PageAddr addr{pageIndex, elementIndex};
+                getMetaByAddr(addr).word = word;
+                pushFreeIndex(getIndexFromAddr(addr), addr);
             }
+            numTombstoneItems += kPageSize;
+            numActivePages++;
+            numInactivePages--;
+            numReclaimed++;
+            SLOT_MAP_INSTRUMENT_INC(pagesAllocated);
+            notifyEvent(&EventHooks::onPageAllocate, pageIndex, 0);
         }
-        else
+
+        if (reusePolicy == slot_map_reuse_policy::dense_first)
         {
-            // recycle index id (note: tag is not saved!)
-            freeIndices.emplace_back(key::clearTagAndUpdateVersion(k, slotVersion));
+            drainRestedIndices();
         }
-        return EraseResult::ErasedAndIndexRecycled;
+        SLOT_MAP_INSTRUMENT_MAX(freeIndicesHighWaterMark, numFreeIndices + numReadyIndices);
+        return numReclaimed;
     }
 
-  public:
-    slot_map()
-        : numItems(0)
-        , maxValidIndex(0)
+    /*
+      Returns the memory resource this slot map allocates from (nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE)
+    */
+    std::pmr::memory_resource* get_memory_resource() const noexcept { return getMemoryResource(); }
+
+#if defined(SLOT_MAP_TRACE)
+    /*
+      Starts recording all the operations (emplace, erase, pop, get, has_key, clear, reset, iteration) into the given trace recorder
+      (nullptr to stop recording). Only available if SLOT_MAP_TRACE is defined.
+      Note: the recorder must outlive the slot map (or be unset). The recorder follows the content on move/swap and is not inherited by copies.
+    */
+    void set_trace_recorder(slot_map_trace_recorder* recorder)
     {
+        traceRecorder = recorder;
+        if (traceRecorder)
+        {
+            traceRecorder->begin(static_cast<uint8_t>(sizeof(key)), static_cast<uint32_t>(sizeof(T)));
+        }
     }
-    ~slot_map() { callDtors(); }
+#endif
 
     /*
       Returns true if the slot map contains a specific key
     */
     bool has_key(key k) const noexcept
     {
-        index_t index = key::toIndex(k);
-        if (index > getMaxValidIndex())
-        {
-            return false;
-        }
-        version_t version = key::toVersion(k);
-        PageAddr addr = getAddrFromIndex(index);
-        if (!isActivePage(addr))
-        {
-            return false;
-        }
-        const Meta& m = getMetaByAddr(addr);
-        return (m.version == version);
+        SLOT_MAP_TRACE_RECORD(HasKey, k);
+        const Meta& m = lookupMeta(key::toIndex(k));
+        return (m.word == getKeyWord(k));
     }
 
     /*
@@ -869,63 +2786,163 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
     */
     void reset()
     {
-        callDtors();
+        SLOT_MAP_TRACE_RECORD(Reset, 0);
+        resetImpl();
+    }
 
-        numItems = 0;
-        maxValidIndex = 0;
+    /*
+      Clears the slot map but keeps the allocated memory for reuse.
+      Automatically increases version for all the removed elements (the same as calling "erase()" for all existing elements)
+    */
+    void clear()
+    {
+        SLOT_MAP_TRACE_RECORD(Clear, 0);
+        clearImpl();
+    }
 
-        // Release used memory (using swap trick)
-        if (!pages.empty())
+    /*
+      Pre-allocates pages so that the next `numElements - size()` emplaces (without erases in between) don't allocate memory.
+      Counts the free indices that would be reused (beyond the reuse threshold) and the never used slots.
+      Handy before a level load: the page vector growth and page allocations are moved off the critical path.
+    */
+    void reserve(size_type numElements)
+    {
+        if (numElements <= numItems)
         {
-            std::vector<Page, stl::Allocator<Page>> tmpPages;
-            pages.swap(tmpPages);
+            return;
+        }
+        size_type numNewItems = numElements - numItems;
+        const size_type numFree = numFreeIndices + numReadyIndices;
+        const size_type numReused = (numFree > reuseThreshold.value) ? (numFree - reuseThreshold.value) : 0;
+        numNewItems -= std::min(numNewItems, numReused);
+        const size_type numUnusedSlots = getNumUnusedSlots();
+        if (numNewItems <= numUnusedSlots)
+        {
+            return;
         }
 
-        if (!freeIndices.empty())
+        const size_type numNewPages = (numNewItems - numUnusedSlots + kPageSize - 1) / kPageSize;
+        const size_type numPages = static_cast<size_type>(pages.size()) + numNewPages;
+        pages.reserve(numPages);
+        if constexpr (kDenseMetaLayout)
+        {
+            metaTable.reserve(static_cast<size_t>(numPages) * kPageSize + 1);
+        }
+        else
+        {
+            pageTable.reserve(static_cast<size_t>(numPages) + 1);
+        }
+        if constexpr (kContiguousLayout)
+        {
+            reserveContiguousStorage(numPages);
+        }
+        for (size_type i = 0; i < numNewPages; i++)
         {
-            std::deque<key, stl::Allocator<key>> tmpFreeIndices;
-            freeIndices.swap(tmpFreeIndices);
+            appendPage();
         }
     }
 
     /*
-      Clears the slot map but keeps the allocated memory for reuse.
-      Automatically increases version for all the removed elements (the same as calling "erase()" for all existing elements)
+      Releases the trailing pages without live values and compacts the internal arrays (pages, page table / version table).
+      Live keys stay valid, values don't move.
+
+      Only one meta word per released page is kept: if the map grows again, the slots of a recreated page continue above
+      every version the released page has handed out (or move to the next page epoch), so stale keys never match again.
+      A trailing page that can't get fresh versions (version overflow without page epoch bits left) stays and stops the shrink.
+      Note: the contiguous layout keeps its storage block unless no pages are left (the block is a single allocation).
     */
-    void clear()
+    void shrink_to_fit()
     {
-        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        // find the trailing pages without live values that could be released
+        size_type firstPage = static_cast<size_type>(pages.size());
+        while (firstPage > 0 && pages[firstPage - 1].numAliveSlots == 0 && getReleasedPageWord(firstPage - 1) != key::kInvalidVersion)
         {
-            Page& page = pages[pageIndex];
-            if (page.meta == nullptr)
+            firstPage--;
+        }
+
+        if (firstPage < pages.size())
+        {
+            removeFreeIndices(firstPage);
+            if (releasedPageWords.size() < pages.size())
             {
-                continue;
+                releasedPageWords.resize(pages.size(), key::kMinVersion);
             }
-            for (size_type elementIndex = 0; elementIndex < page.numUsedElements; elementIndex++)
+            while (pages.size() > firstPage)
             {
-                index_t index = getIndexFromAddr(PageAddr{static_cast<size_type>(pageIndex), elementIndex});
-                // note: version doesn't matter here
-                EraseResult res = eraseImpl<false>(key::make(key::kMinVersion, index));
-                if (res == EraseResult::ErasedAndPageDeactivated)
+                const size_type pageIndex = static_cast<size_type>(pages.size()) - 1;
+                Page& page = pages.back();
+                releasedPageWords[pageIndex] = getReleasedPageWord(pageIndex);
+                if (page.isActive())
+                {
+                    numTombstoneItems -= page.numUsedElements - page.numInactiveSlots;
+                    numInactiveItems -= page.numInactiveSlots;
+                    SLOT_MAP_INSTRUMENT_INC(pagesFreed);
+                    notifyEvent(&EventHooks::onPageRelease, pageIndex, 0);
+                    numActivePages--;
+                }
+                else
+                {
+                    numInactivePages--;
+                }
+                pages.pop_back();
+            }
+            SLOT_MAP_ASSERT(numFreeIndices + numReadyIndices == numTombstoneItems);
+
+            if constexpr (kDenseMetaLayout)
+            {
+                metaTable.resize(pages.empty() ? 0 : pages.size() * kPageSize + 1);
+                if (!metaTable.empty())
+                {
+                    metaTable.back() = kInvalidMeta;
+                }
+            }
+            else
+            {
+                pageTable.resize(pages.empty() ? 0 : pages.size() + 1);
+                if (!pageTable.empty())
+                {
+                    pageTable.back() = kInvalidPageEntry;
+                }
+            }
+
+            // the last fresh index is in the last used page
+            maxValidIndex = 0;
+            for (size_type pageIndex = static_cast<size_type>(pages.size()); pageIndex > 0; pageIndex--)
+            {
+                if (pages[pageIndex - 1].numUsedElements != 0)
                 {
-                    // noting left on this page - go to the next page
+                    maxValidIndex = getIndexFromAddr(PageAddr{pageIndex - 1, pages[pageIndex - 1].numUsedElements - 1});
                     break;
                 }
             }
         }
-        SLOT_MAP_ASSERT(numItems == 0);
+
+        if (pages.empty())
+        {
+            storage.release();
+        }
+        pages.shrink_to_fit();
+        pageTable.shrink_to_fit();
+        metaTable.shrink_to_fit();
+        releasedPageWords.shrink_to_fit();
+        updatePageTableView();
     }
 
     /*
       If key exists returns a const pointer to the value corresponding to the given key or returns null elsewere.
     */
-    const T* get(key k) const noexcept { return getImpl(k); }
+    const T* get(key k) const noexcept
+    {
+        SLOT_MAP_TRACE_RECORD(Get, k);
+        return getImpl(k);
+    }
 
     /*
       If key exists returns a pointer to the value corresponding to the given key or returns null elsewere.
     */
     T* get(key k) noexcept
     {
+        SLOT_MAP_TRACE_RECORD(Get, k);
         const T* constRes = getImpl(k);
         return const_cast<T*>(constRes);
     }
@@ -935,55 +2952,27 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
     */
     template <class... Args> key emplace(Args&&... args)
     {
-        // Use recycled IDs only if we accumulated enough of them
-        if (static_cast<size_type>(freeIndices.size()) > kMinFreeIndices)
-        {
-            key k = freeIndices.front();
-            freeIndices.pop_front();
-
-            index_t index = key::toIndex(k);
-            SLOT_MAP_ASSERT(index <= getMaxValidIndex());
-
-            PageAddr addr = getAddrFromIndex(index);
-            Meta& m = getMetaByAddr(addr);
-            SLOT_MAP_ASSERT(m.inactive == 0);
-            SLOT_MAP_ASSERT(m.tombstone != 0);
-            SLOT_MAP_ASSERT(k.get_tag() == 0);
-
-            m.tombstone = 0;
-
-            ValueStorage& v = getValueByAddr(addr);
-            construct<T>(&v, std::forward<Args>(args)...);
-            numItems++;
-            return k;
-        }
-
-        // allocate new item
-        index_t index = appendElement();
-        maxValidIndex = std::max(maxValidIndex, index);
-
-        PageAddr addr = getAddrFromIndex(index);
-        const Meta& m = getMetaByAddr(addr);
-        SLOT_MAP_ASSERT(m.tombstone == 0);
-
-        ValueStorage& v = getValueByAddr(addr);
-        construct<T>(&v, std::forward<Args>(args)...);
-        numItems++;
-        key k = key::make(m.version, index);
+        key k = emplaceImpl(std::forward<Args>(args)...);
+        SLOT_MAP_TRACE_RECORD(Emplace, k);
         return k;
     }
 
     /*
       Removes element (if such key exists) from the slot map.
     */
-    void erase(key k) { eraseImpl<true>(k); }
+    void erase(key k)
+    {
+        SLOT_MAP_TRACE_RECORD(Erase, k);
+        eraseImpl<true>(k);
+    }
 
     /*
       Removes element (if such key exists) from the slot map, returning the value at the key if the key was not previously removed.
     */
     std::optional<T> pop(key k)
     {
-        T* val = get(k);
+        SLOT_MAP_TRACE_RECORD(Pop, k);
+        T* val = const_cast<T*>(getImpl(k));
         if (val == nullptr)
         {
             return {};
@@ -1010,15 +2999,58 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
     void swap(slot_map& other) noexcept
     {
         pages.swap(other.pages);
-        freeIndices.swap(other.freeIndices);
+        pageTable.swap(other.pageTable);
+        metaTable.swap(other.metaTable);
+        releasedPageWords.swap(other.releasedPageWords);
+        storage.swap(other.storage);
+        updatePageTableView();
+        other.updatePageTableView();
+        std::swap(freeListHead, other.freeListHead);
+        std::swap(freeListTail, other.freeListTail);
+        std::swap(numFreeIndices, other.numFreeIndices);
+        std::swap(readyBuckets, other.readyBuckets);
+        std::swap(numReadyIndices, other.numReadyIndices);
+        std::swap(reusePolicy, other.reusePolicy);
+        std::swap(reuseThreshold, other.reuseThreshold);
         std::swap(numItems, other.numItems);
         std::swap(maxValidIndex, other.maxValidIndex);
+        std::swap(numTombstoneItems, other.numTombstoneItems);
+        std::swap(numInactiveItems, other.numInactiveItems);
+        std::swap(numActivePages, other.numActivePages);
+        std::swap(numInactivePages, other.numInactivePages);
+        std::swap(eventHooks, other.eventHooks);
+        std::swap(pageAllocator, other.pageAllocator);
+#if defined(SLOT_MAP_TRACE)
+        std::swap(traceRecorder, other.traceRecorder);
+#endif
     }
 
     // copy constructor
     slot_map(const slot_map& other)
-        : numItems(0)
+        : pages(other.pages.get_allocator())
+        , pageTable(other.pageTable.get_allocator())
+        , pageTableData(&kInvalidPageEntry)
+        , maxPageTableIndex(0)
+        , metaTable(other.metaTable.get_allocator())
+        , metaTableData(&kInvalidMeta)
+        , maxMetaTableIndex(0)
+        , releasedPageWords(other.releasedPageWords.get_allocator())
+        , freeListHead(kInvalidFreeIndex)
+        , freeListTail(kInvalidFreeIndex)
+        , numFreeIndices(0)
+        , numReadyIndices(0)
+        , reusePolicy(slot_map_reuse_policy::fifo)
+        , numItems(0)
         , maxValidIndex(0)
+        , numTombstoneItems(0)
+        , numInactiveItems(0)
+        , numActivePages(0)
+        , numInactivePages(0)
+        , eventHooks(other.eventHooks)
+        , pageAllocator(other.pageAllocator)
+#if defined(SLOT_MAP_TRACE)
+        , traceRecorder(nullptr)
+#endif
     {
         copyFrom(other);
     }
@@ -1032,25 +3064,85 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
     // move constructor
     slot_map(slot_map&& other) noexcept
-        : numItems(other.numItems)
+        : pageTableData(&kInvalidPageEntry)
+        , maxPageTableIndex(0)
+        , metaTableData(&kInvalidMeta)
+        , maxMetaTableIndex(0)
+        , freeListHead(other.freeListHead)
+        , freeListTail(other.freeListTail)
+        , numFreeIndices(other.numFreeIndices)
+        , numReadyIndices(other.numReadyIndices)
+        , reusePolicy(other.reusePolicy)
+        , reuseThreshold(other.reuseThreshold)
+        , numItems(other.numItems)
         , maxValidIndex(other.maxValidIndex)
+        , numTombstoneItems(other.numTombstoneItems)
+        , numInactiveItems(other.numInactiveItems)
+        , numActivePages(other.numActivePages)
+        , numInactivePages(other.numInactivePages)
+        , eventHooks(other.eventHooks)
+        , pageAllocator(other.pageAllocator)
+#if defined(SLOT_MAP_TRACE)
+        , traceRecorder(other.traceRecorder)
+#endif
     {
         std::swap(pages, other.pages);
-        std::swap(freeIndices, other.freeIndices);
+        std::swap(pageTable, other.pageTable);
+        std::swap(metaTable, other.metaTable);
+        std::swap(releasedPageWords, other.releasedPageWords);
+        storage.swap(other.storage);
+        std::copy(std::begin(other.readyBuckets), std::end(other.readyBuckets), std::begin(readyBuckets));
+        updatePageTableView();
+        other.updatePageTableView();
+        other.freeListHead = kInvalidFreeIndex;
+        other.freeListTail = kInvalidFreeIndex;
+        other.numFreeIndices = 0;
+        std::fill(std::begin(other.readyBuckets), std::end(other.readyBuckets), kInvalidPageIndex);
+        other.numReadyIndices = 0;
         other.numItems = 0;
         other.maxValidIndex = 0;
+        other.numTombstoneItems = 0;
+        other.numInactiveItems = 0;
+        other.numActivePages = 0;
+        other.numInactivePages = 0;
+        other.eventHooks = nullptr;
+        other.pageAllocator = nullptr;
+#if defined(SLOT_MAP_TRACE)
+        other.traceRecorder = nullptr;
+#endif
     }
 
     // move asignment
     slot_map& operator=(slot_map&& other) noexcept
     {
         // reset and swap
-        reset();
+        resetImpl();
 
         pages.swap(other.pages);
-        freeIndices.swap(other.freeIndices);
+        pageTable.swap(other.pageTable);
+        metaTable.swap(other.metaTable);
+        releasedPageWords.swap(other.releasedPageWords);
+        storage.swap(other.storage);
+        updatePageTableView();
+        other.updatePageTableView();
+        std::swap(freeListHead, other.freeListHead);
+        std::swap(freeListTail, other.freeListTail);
+        std::swap(numFreeIndices, other.numFreeIndices);
+        std::swap(readyBuckets, other.readyBuckets);
+        std::swap(numReadyIndices, other.numReadyIndices);
+        std::swap(reusePolicy, other.reusePolicy);
+        std::swap(reuseThreshold, other.reuseThreshold);
         std::swap(numItems, other.numItems);
         std::swap(maxValidIndex, other.maxValidIndex);
+        std::swap(numTombstoneItems, other.numTombstoneItems);
+        std::swap(numInactiveItems, other.numInactiveItems);
+        std::swap(numActivePages, other.numActivePages);
+        std::swap(numInactivePages, other.numInactivePages);
+        std::swap(eventHooks, other.eventHooks);
+        std::swap(pageAllocator, other.pageAllocator);
+#if defined(SLOT_MAP_TRACE)
+        std::swap(traceRecorder, other.traceRecorder);
+#endif
         return *this;
     }
 
@@ -1067,7 +3159,27 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
     };
 
     /*
-      Returns the internal stats for debug purposes
+      Returns the internal stats (maintained incrementally)
+
+      Note: O(1) complexity
+    */
+    Stats stats() const noexcept
+    {
+        Stats res;
+        res.numPagesTotal = static_cast<size_type>(pages.size());
+        res.numInactivePages = numInactivePages;
+        res.numActivePages = numActivePages;
+
+        res.numAliveItems = numItems;
+        res.numTombstoneItems = numTombstoneItems;
+        res.numInactiveItems = numInactiveItems;
+        res.numItemsTotal = numItems + numTombstoneItems + numInactiveItems;
+        return res;
+    }
+
+    /*
+      Returns the internal stats for debug purposes (calculated by walking over all the slots)
+      Also validates that the incrementally maintained stats() are consistent with the actual slots state.
 
       Note: O(n) complexity!
     */
@@ -1079,7 +3191,7 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
         for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
         {
             const Page& page = pages[pageIndex];
-            if (page.meta == nullptr)
+            if (!page.isActive())
             {
                 stats.numInactivePages++;
                 continue;
@@ -1087,17 +3199,21 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
             stats.numActivePages++;
 
             stats.numItemsTotal += page.numUsedElements;
+            size_type numPageAliveItems = 0;
             for (size_type elementIndex = 0; elementIndex < page.numUsedElements; elementIndex++)
             {
                 PageAddr addr;
                 addr.page = static_cast<size_type>(pageIndex);
                 addr.index = static_cast<size_type>(elementIndex);
                 const Meta& m = getMetaByAddr(addr);
-                if (m.inactive != 0)
+                SLOT_MAP_ASSERT(page.isAlive(elementIndex) == !m.isTombstone());
+                SLOT_MAP_ASSERT(!m.isInactive() || m.isTombstone());
+                numPageAliveItems += m.isTombstone() ? 0 : 1;
+                if (m.isInactive())
                 {
                     stats.numInactiveItems++;
                 }
-                else if (m.tombstone != 0)
+                else if (m.isTombstone())
                 {
                     stats.numTombstoneItems++;
                 }
@@ -1106,10 +3222,202 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
                     stats.numAliveItems++;
                 }
             }
+            SLOT_MAP_ASSERT(numPageAliveItems == page.numAliveSlots);
+            SLOT_MAP_ASSERT(page.numReadySlots == 0 || page.readyBucket == getReuseBucket(page.numAliveSlots));
+            (void)numPageAliveItems;
         }
+
+        SLOT_MAP_ASSERT(stats.numInactivePages == numInactivePages);
+        SLOT_MAP_ASSERT(stats.numActivePages == numActivePages);
+        SLOT_MAP_ASSERT(stats.numAliveItems == numItems);
+        SLOT_MAP_ASSERT(stats.numTombstoneItems == numTombstoneItems);
+        SLOT_MAP_ASSERT(stats.numInactiveItems == numInactiveItems);
+        // every tombstone (that is not inactive) is either in the FIFO free list or a rested slot
+        SLOT_MAP_ASSERT(numFreeIndices + numReadyIndices == numTombstoneItems);
         return stats;
     }
 
+#if defined(SLOT_MAP_INSTRUMENT)
+    /*
+      Hot-path instrumentation counters (only available if SLOT_MAP_INSTRUMENT is defined)
+      Note: counters belong to the instance, they are not copied, moved or swapped along with the content.
+      Note: counters are relaxed atomics, so concurrent readers (get/has_key on a const map) don't race.
+    */
+    struct InstrumentCounters
+    {
+        std::atomic<uint64_t> getHits{0};
+        std::atomic<uint64_t> getMissesOutOfRange{0};
+        std::atomic<uint64_t> getMissesInactivePage{0};
+        std::atomic<uint64_t> getMissesVersionMismatch{0};
+
+        std::atomic<uint64_t> emplaceRecycled{0};
+        std::atomic<uint64_t> emplaceFresh{0};
+
+        std::atomic<uint64_t> slotsDeactivated{0};
+        std::atomic<uint64_t> pagesAllocated{0};
+        std::atomic<uint64_t> pagesFreed{0};
+
+        std::atomic<uint64_t> freeIndicesHighWaterMark{0};
+    };
+
+    const InstrumentCounters& instrument_counters() const noexcept { return instrument; }
+
+    void reset_instrument_counters() noexcept
+    {
+        for (std::atomic<uint64_t>* counter :
+             {&instrument.getHits, &instrument.getMissesOutOfRange, &instrument.getMissesInactivePage, &instrument.getMissesVersionMismatch,
+              &instrument.emplaceRecycled, &instrument.emplaceFresh, &instrument.slotsDeactivated, &instrument.pagesAllocated,
+              &instrument.pagesFreed, &instrument.freeIndicesHighWaterMark})
+        {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+      Returns instrumentation counters as a JSON object
+    */
+    std::string instrument_json() const
+    {
+        auto load = [](const std::atomic<uint64_t>& counter) { return counter.load(std::memory_order_relaxed); };
+        char buf[1024];
+        int len = snprintf(buf, sizeof(buf),
+                           "{\"get_hits\":%" PRIu64 ",\"get_misses_out_of_range\":%" PRIu64 ",\"get_misses_inactive_page\":%" PRIu64
+                           ",\"get_misses_version_mismatch\":%" PRIu64 ",\"emplace_recycled\":%" PRIu64 ",\"emplace_fresh\":%" PRIu64
+                           ",\"slots_deactivated\":%" PRIu64 ",\"pages_allocated\":%" PRIu64 ",\"pages_freed\":%" PRIu64
+                           ",\"free_indices_high_water_mark\":%" PRIu64 "}",
+                           load(instrument.getHits), load(instrument.getMissesOutOfRange), load(instrument.getMissesInactivePage),
+                           load(instrument.getMissesVersionMismatch), load(instrument.emplaceRecycled), load(instrument.emplaceFresh),
+                           load(instrument.slotsDeactivated), load(instrument.pagesAllocated), load(instrument.pagesFreed),
+                           load(instrument.freeIndicesHighWaterMark));
+        SLOT_MAP_ASSERT(len > 0 && len < static_cast<int>(sizeof(buf)));
+        return std::string(buf, static_cast<size_t>(len));
+    }
+
+    /*
+      Writes instrumentation counters as a JSON object to the given file
+    */
+    void write_instrument_json(FILE* f) const
+    {
+        SLOT_MAP_ASSERT(f);
+        std::string json = instrument_json();
+        fwrite(json.data(), 1, json.size(), f);
+    }
+#endif
+
+    struct MemoryStats
+    {
+        // bytes reserved by all the active pages (values + meta + padding)
+        size_t pageBytesReserved = 0;
+        // bytes reserved for values (all the slots of the active pages)
+        size_t valueBytesReserved = 0;
+        // bytes occupied by live values
+        size_t liveValueBytes = 0;
+        // bytes reserved for values but not occupied by live values (tombstone, inactive and not yet used slots)
+        size_t wastedValueBytes = 0;
+        // bytes held by meta (versions, slot markers and live slots bitmaps)
+        size_t metaBytes = 0;
+        // bytes held by the pages vector and the lookup page table (capacity)
+        size_t pagesVectorBytes = 0;
+        // bytes held by the dense version table (dense meta layout only, capacity)
+        size_t metaTableBytes = 0;
+        // bytes held by the free indices queue (always 0: the free list is stored in the tombstoned slots)
+        size_t freeIndicesBytes = 0;
+        // total memory footprint (pages + pages vector + version table + free indices)
+        size_t totalBytes = 0;
+    };
+
+    /*
+      Returns the size of one page allocation in bytes (see slot_map_page_size_for_bytes)
+    */
+    static constexpr size_t page_size_in_bytes() noexcept
+    {
+        static_assert(kPageLayout.numBytes == slot_map_page_bytes_for_size<T, TKeyType, TLayout>(kPageSize),
+                      "slot_map_page_bytes_for_size is expected to match the page layout");
+        return static_cast<size_t>(kPageLayout.numBytes);
+    }
+
+    /*
+      Returns memory accounting info
+
+      Note: O(1) complexity
+    */
+    MemoryStats memory_stats() const noexcept
+    {
+        const PageLayout& layout = kPageLayout;
+
+        MemoryStats res;
+        if constexpr (kContiguousLayout)
+        {
+            // the whole storage (including the memory of released pages and the reserved capacity)
+            res.pageBytesReserved = storage.numBytes();
+        }
+        else
+        {
+            res.pageBytesReserved = static_cast<size_t>(numActivePages) * layout.numBytes;
+        }
+        res.valueBytesReserved = static_cast<size_t>(numActivePages) * layout.dataSize;
+        res.liveValueBytes = static_cast<size_t>(numItems) * sizeof(ValueStorage);
+        res.wastedValueBytes = res.valueBytesReserved - res.liveValueBytes;
+        res.metaBytes = static_cast<size_t>(numActivePages) * (layout.metaSize + layout.bitmapSize);
+        res.pagesVectorBytes = pages.capacity() * sizeof(Page) + pageTable.capacity() * sizeof(PageEntry);
+        res.metaTableBytes = metaTable.capacity() * sizeof(Meta);
+        res.metaBytes += res.metaTableBytes;
+        res.freeIndicesBytes = 0;
+        res.totalBytes = res.pageBytesReserved + res.pagesVectorBytes + res.metaTableBytes + res.freeIndicesBytes;
+        return res;
+    }
+
+    struct PageOccupancy
+    {
+        bool active = false;
+        size_type numAliveItems = 0;
+        size_type numTombstoneItems = 0;
+        size_type numInactiveItems = 0;
+        // slots that have never been used (only the last page could have them)
+        size_type numUnusedItems = 0;
+    };
+
+    /*
+      Returns per-page occupancy histogram (one entry per page) for debug purposes
+
+      Note: O(n) complexity!
+    */
+    std::vector<PageOccupancy> debug_page_occupancy() const
+    {
+        std::vector<PageOccupancy> res;
+        res.resize(pages.size());
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            const Page& page = pages[pageIndex];
+            PageOccupancy& occupancy = res[pageIndex];
+            occupancy.numUnusedItems = kPageSize - page.numUsedElements;
+            if (!page.isActive())
+            {
+                occupancy.numInactiveItems = page.numInactiveSlots;
+                continue;
+            }
+            occupancy.active = true;
+
+            for (size_type elementIndex = 0; elementIndex < page.numUsedElements; elementIndex++)
+            {
+                const Meta& m = getMetaByAddr(PageAddr{static_cast<size_type>(pageIndex), elementIndex});
+                if (m.isInactive())
+                {
+                    occupancy.numInactiveItems++;
+                }
+                else if (m.isTombstone())
+                {
+                    occupancy.numTombstoneItems++;
+                }
+                else
+                {
+                    occupancy.numAliveItems++;
+                }
+            }
+        }
+        return res;
+    }
+
   public:
     // iterators.....
 
@@ -1151,10 +3459,7 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
         const_values_iterator& operator++() noexcept
         {
-            do
-            {
-                currentIndex++;
-            } while (currentIndex <= slotMap->getMaxValidIndex() && slotMap->isTombstone(currentIndex));
+            currentIndex = slotMap->findNextAlive(currentIndex + 1);
             return *this;
         }
 
@@ -1172,14 +3477,8 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
     const_values_iterator begin() const noexcept
     {
-        if (pages.empty()) return end();
-
-        size_type index = 0;
-        while (index <= getMaxValidIndex() && isTombstone(index))
-        {
-            index++;
-        }
-        return const_values_iterator(this, index);
+        SLOT_MAP_TRACE_RECORD(IterateValues, 0);
+        return const_values_iterator(this, findNextAlive(0));
     }
     const_values_iterator end() const noexcept { return const_values_iterator(this, getMaxValidIndex() + static_cast<size_type>(1)); }
 
@@ -1224,7 +3523,7 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
             const Meta& m = slotMap->getMetaByAddr(addr);
             const ValueStorage& v = slotMap->getValueByAddr(addr);
             const T* value = reinterpret_cast<const T*>(&v);
-            tmpKv.first = key::make(m.version, index_t(currentIndex));
+            tmpKv.first = makeKey(m.word, index_t(currentIndex));
             const reference<const T>& ref = tmpKv.second;
             const_cast<reference<const T>&>(ref).set(value);
         }
@@ -1260,10 +3559,7 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
         const_kv_iterator& operator++() noexcept
         {
-            do
-            {
-                currentIndex++;
-            } while (currentIndex <= slotMap->getMaxValidIndex() && slotMap->isTombstone(currentIndex));
+            currentIndex = slotMap->findNextAlive(currentIndex + 1);
             return *this;
         }
 
@@ -1294,13 +3590,13 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
         const_kv_iterator begin() const noexcept
         {
-            if (slotMap->pages.empty()) return end();
-            size_type index = 0;
-            while (index <= slotMap->getMaxValidIndex() && slotMap->isTombstone(index))
+#if defined(SLOT_MAP_TRACE)
+            if (slotMap->traceRecorder)
             {
-                index++;
+                slotMap->traceRecorder->record(slot_map_trace_op::IterateItems, 0);
             }
-            return const_kv_iterator(slotMap, index);
+#endif
+            return const_kv_iterator(slotMap, slotMap->findNextAlive(0));
         }
         const_kv_iterator end() const noexcept
         {
@@ -1312,16 +3608,59 @@ template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4
 
   private:
     std::vector<Page, stl::Allocator<Page>> pages;
-    std::deque<key, stl::Allocator<key>> freeIndices;
+    // pages.size() + 1 entries (or empty), see PageEntry
+    std::vector<PageEntry, stl::Allocator<PageEntry>> pageTable;
+    // pageTable.data() or the sentinel entry if the page table is empty
+    const PageEntry* pageTableData;
+    size_type maxPageTableIndex;
+    // dense version table (dense meta layout only): pages.size() * kPageSize + 1 entries (or empty)
+    std::vector<Meta, stl::Allocator<Meta>> metaTable;
+    // metaTable.data() or the sentinel meta if the table is empty
+    const Meta* metaTableData;
+    size_type maxMetaTableIndex;
+    // contiguous layout only: values and live slots bitmaps of all the pages
+    ContiguousStorage storage;
+    // first meta word of the pages released by shrink_to_fit (indexed by page index, only the entries >= pages.size() are used)
+    std::vector<version_t, stl::Allocator<version_t>> releasedPageWords;
+    // FIFO list of recycled slots (oldest first), see pushFreeIndex
+    index_t freeListHead;
+    index_t freeListTail;
+    size_type numFreeIndices;
+    // dense_first reuse policy: first page of every occupancy bucket (see pushReadyIndex)
+    size_type readyBuckets[kNumReuseBuckets];
+    size_type numReadyIndices;
+    slot_map_reuse_policy reusePolicy;
+    ReuseThreshold reuseThreshold;
     size_type numItems;
     index_t maxValidIndex;
+    size_type numTombstoneItems;
+    size_type numInactiveItems;
+    size_type numActivePages;
+    size_type numInactivePages;
+    const EventHooks* eventHooks;
+    slot_map_page_allocator* pageAllocator;
+#if defined(SLOT_MAP_TRACE)
+    slot_map_trace_recorder* traceRecorder;
+#endif
+#if defined(SLOT_MAP_INSTRUMENT)
+    mutable InstrumentCounters instrument;
+#endif
 };
 
-template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
-using slot_map32 = slot_map<T, dod::slot_map_key32<T>, PAGESIZE, MINFREEINDICES>;
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64, typename TLayout = slot_map_layout_split>
+using slot_map32 = slot_map<T, dod::slot_map_key32<T>, PAGESIZE, MINFREEINDICES, TLayout>;
 
-template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
-using slot_map64 = slot_map<T, dod::slot_map_key64<T>, PAGESIZE, MINFREEINDICES>;
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64, typename TLayout = slot_map_layout_split>
+using slot_map64 = slot_map<T, dod::slot_map_key64<T>, PAGESIZE, MINFREEINDICES, TLayout>;
+
+// page size is specified as a byte budget (see slot_map_page_size_for_bytes)
+template <class T, size_t PAGEBYTES = 64 * 1024, size_t MINFREEINDICES = 64, typename TLayout = slot_map_layout_split>
+using slot_map32_page_bytes =
+    slot_map<T, dod::slot_map_key32<T>, slot_map_page_size_for_bytes<T, dod::slot_map_key32<T>, TLayout>(PAGEBYTES), MINFREEINDICES, TLayout>;
+
+template <class T, size_t PAGEBYTES = 64 * 1024, size_t MINFREEINDICES = 64, typename TLayout = slot_map_layout_split>
+using slot_map64_page_bytes =
+    slot_map<T, dod::slot_map_key64<T>, slot_map_page_size_for_bytes<T, dod::slot_map_key64<T>, TLayout>(PAGEBYTES), MINFREEINDICES, TLayout>;
 
 } // namespace dod
 
@@ -1338,4 +3677,14 @@ template <typename T> struct hash<typename dod::slot_map_key32<T>>
     size_t operator()(const typename dod::slot_map_key32<T>& key) const noexcept { return key.hash(); }
 };
 
+template <typename T, uint32_t EPOCH_BITS> struct hash<typename dod::slot_map_key64_epoch<T, EPOCH_BITS>>
+{
+    size_t operator()(const typename dod::slot_map_key64_epoch<T, EPOCH_BITS>& key) const noexcept { return key.hash(); }
+};
+
+template <typename T, uint32_t EPOCH_BITS> struct hash<typename dod::slot_map_key32_epoch<T, EPOCH_BITS>>
+{
+    size_t operator()(const typename dod::slot_map_key32_epoch<T, EPOCH_BITS>& key) const noexcept { return key.hash(); }
+};
+
 } // namespace std
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "slot_map.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace dod
+{
+
+/*
+  Page pool shared by slot map instances
+
+  Recycles page blocks by size class (page size in bytes + alignment), so page churn (level load/unload, create/destroy cycles)
+  doesn't reach the system allocator. Blocks are only returned to the system by trim() or on pool destruction.
+
+  ```
+  dod::slot_map_page_pool pool;
+
+  dod::slot_map<Enemy> enemies;
+  enemies.set_page_allocator(&pool);
+  dod::slot_map<Projectile> projectiles;
+  projectiles.set_page_allocator(&pool);
+  ...
+  // after level unload
+  pool.trim();
+  ```
+
+  Thread safety: allocate_page/free_page could be called from any thread (slot maps themselves are not thread safe).
+  Every thread keeps a small cache of the recently freed blocks (up to kThreadCacheNumClasses size classes per thread, kThreadCacheSize
+  blocks each) that is checked before the shared lists. Frees of more size classes at once go to the shared lists (pool mutex).
+  trim() and the pool destructor reclaim the blocks cached by every thread, a thread's cache is flushed to the shared lists
+  when the thread exits.
+*/
+class slot_map_page_pool : public slot_map_page_allocator
+{
+  public:
+    // max number of blocks of one size class in a per thread cache
+    static inline constexpr size_t kThreadCacheSize = 8;
+    // max number of size classes (size + alignment + pool) in a per thread cache
+    static inline constexpr size_t kThreadCacheNumClasses = 4;
+
+    struct Stats
+    {
+        // blocks requested from the system allocator
+        uint64_t numSystemAllocations = 0;
+        // blocks returned to the system allocator
+        uint64_t numSystemFrees = 0;
+        // allocations served by the pool (shared lists or thread caches)
+        uint64_t numReused = 0;
+        // blocks (and bytes) in the shared lists
+        size_t numCachedBlocks = 0;
+        size_t cachedBytes = 0;
+    };
+
+    slot_map_page_pool() noexcept
+    {
+        // note: constructs the registry before the pool, so that it outlives pools with static storage duration
+        getCacheRegistry();
+    }
+
+    slot_map_page_pool(const slot_map_page_pool&) = delete;
+    slot_map_page_pool& operator=(const slot_map_page_pool&) = delete;
+
+    ~slot_map_page_pool() override { trim(); }
+
+    void* allocate_page(size_t sizeInBytes, size_t alignment) override
+    {
+        void* ptr = nullptr;
+        if (ThreadCache* cache = getThreadCache())
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            ptr = cache->pop(this, sizeInBytes, alignment);
+        }
+        if (ptr)
+        {
+            numReused.fetch_add(1, std::memory_order_relaxed);
+            return ptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            SizeClass* sizeClass = findSizeClass(sizeInBytes, alignment);
+            if (sizeClass && !sizeClass->blocks.empty())
+            {
+                ptr = sizeClass->blocks.back();
+                sizeClass->blocks.pop_back();
+                cachedBytes -= sizeInBytes;
+                numReused.fetch_add(1, std::memory_order_relaxed);
+                return ptr;
+            }
+
+            // note: reserve room for the new block in the shared list up front, so free_page never allocates
+            if (sizeClass == nullptr)
+            {
+                sizeClasses.push_back(SizeClass{sizeInBytes, alignment, {}, 0});
+                sizeClass = &sizeClasses.back();
+            }
+            if (sizeClass->blocks.capacity() <= sizeClass->numAllocated)
+            {
+                sizeClass->blocks.reserve(std::max(sizeClass->blocks.capacity() * 2, size_t(8)));
+            }
+            sizeClass->numAllocated++;
+        }
+
+        // note: the system allocator is called outside of the pool mutex
+        ptr = SLOT_MAP_ALLOC(sizeInBytes, alignment);
+        if (ptr == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            findSizeClass(sizeInBytes, alignment)->numAllocated--;
+            throw std::bad_alloc();
+        }
+        numSystemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    void free_page(void* ptr, size_t sizeInBytes, size_t alignment) noexcept override
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        if (ThreadCache* cache = getThreadCache())
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            if (cache->push(this, sizeInBytes, alignment, ptr))
+            {
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        pushShared(ptr, sizeInBytes, alignment);
+    }
+
+    /*
+      Returns cached blocks to the system allocator until no more than `maxCachedBytes` bytes are cached in the shared lists
+      (flushes the blocks cached by every thread into the shared lists first).
+    */
+    void trim(size_t maxCachedBytes = 0) noexcept
+    {
+        {
+            CacheRegistry& registry = getCacheRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (ThreadCache* cache = registry.head; cache; cache = cache->next)
+            {
+                std::lock_guard<std::mutex> cacheLock(cache->mutex);
+                flushThreadCache(*cache);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (SizeClass& sizeClass : sizeClasses)
+        {
+            while (cachedBytes > maxCachedBytes && !sizeClass.blocks.empty())
+            {
+                SLOT_MAP_FREE(sizeClass.blocks.back());
+                sizeClass.blocks.pop_back();
+                sizeClass.numAllocated--;
+                cachedBytes -= sizeClass.sizeInBytes;
+                numSystemFrees.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Stats stats() const
+    {
+        Stats res;
+        res.numSystemAllocations = numSystemAllocations.load(std::memory_order_relaxed);
+        res.numSystemFrees = numSystemFrees.load(std::memory_order_relaxed);
+        res.numReused = numReused.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const SizeClass& sizeClass : sizeClasses)
+        {
+            res.numCachedBlocks += sizeClass.blocks.size();
+        }
+        res.cachedBytes = cachedBytes;
+        return res;
+    }
+
+  private:
+    struct SizeClass
+    {
+        size_t sizeInBytes;
+        size_t alignment;
+        // note: capacity is kept >= numAllocated, so returning a block never allocates
+        std::vector<void*> blocks;
+        // blocks of this size class requested from the system allocator and not freed yet
+        size_t numAllocated;
+    };
+
+    struct ThreadCache;
+
+    /*
+      All the thread caches (shared by all the pools), lets a pool reclaim its blocks from the caches of other threads.
+      Lock order: registry mutex -> cache mutex -> pool mutex.
+    */
+    struct CacheRegistry
+    {
+        std::mutex mutex;
+        // intrusive list, registering a cache never allocates
+        ThreadCache* head = nullptr;
+    };
+
+    static CacheRegistry& getCacheRegistry() noexcept
+    {
+        static CacheRegistry registry;
+        return registry;
+    }
+
+    // blocks of a single size class of a single pool in a per thread cache
+    struct ThreadCacheClass
+    {
+        slot_map_page_pool* pool = nullptr;
+        size_t sizeInBytes = 0;
+        size_t alignment = 0;
+        size_t numBlocks = 0;
+        void* blocks[kThreadCacheSize] = {};
+
+        bool matches(const slot_map_page_pool* _pool, size_t _sizeInBytes, size_t _alignment) const noexcept
+        {
+            return pool == _pool && sizeInBytes == _sizeInBytes && alignment == _alignment;
+        }
+    };
+
+    /*
+      Per thread cache (up to kThreadCacheNumClasses size classes, possibly of different pools)
+      Only the owning thread pushes/pops, the mutex is contended only while a pool reclaims its blocks (trim/destruction).
+      A pool always reclaims all of its blocks before it dies, so a cache never holds the blocks of a destroyed pool.
+    */
+    struct ThreadCache
+    {
+        std::mutex mutex;
+        ThreadCacheClass classes[kThreadCacheNumClasses];
+        ThreadCache* prev = nullptr;
+        ThreadCache* next = nullptr;
+
+        ThreadCache() noexcept
+        {
+            CacheRegistry& registry = getCacheRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            next = registry.head;
+            if (next)
+            {
+                next->prev = this;
+            }
+            registry.head = this;
+        }
+
+        ~ThreadCache()
+        {
+            {
+                CacheRegistry& registry = getCacheRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                (prev ? prev->next : registry.head) = next;
+                if (next)
+                {
+                    next->prev = prev;
+                }
+                // note: the pools can't be destroyed while the registry is locked
+                std::lock_guard<std::mutex> cacheLock(mutex);
+                for (ThreadCacheClass& cacheClass : classes)
+                {
+                    if (cacheClass.pool)
+                    {
+                        cacheClass.pool->flushThreadCache(*this);
+                    }
+                }
+            }
+            isThreadCacheDestroyed() = true;
+        }
+
+        void* pop(const slot_map_page_pool* _pool, size_t _sizeInBytes, size_t _alignment) noexcept
+        {
+            for (ThreadCacheClass& cacheClass : classes)
+            {
+                if (cacheClass.numBlocks != 0 && cacheClass.matches(_pool, _sizeInBytes, _alignment))
+                {
+                    return cacheClass.blocks[--cacheClass.numBlocks];
+                }
+            }
+            return nullptr;
+        }
+
+        bool push(slot_map_page_pool* _pool, size_t _sizeInBytes, size_t _alignment, void* ptr) noexcept
+        {
+            ThreadCacheClass* target = nullptr;
+            for (ThreadCacheClass& cacheClass : classes)
+            {
+                if (cacheClass.pool && cacheClass.matches(_pool, _sizeInBytes, _alignment))
+                {
+                    target = &cacheClass;
+                    break;
+                }
+                if (target == nullptr && cacheClass.numBlocks == 0)
+                {
+                    // the first empty class is rebound unless the size class is bound further on
+                    target = &cacheClass;
+                }
+            }
+            if (target == nullptr || target->numBlocks == kThreadCacheSize)
+            {
+                return false;
+            }
+            if (target->numBlocks == 0)
+            {
+                target->pool = _pool;
+                target->sizeInBytes = _sizeInBytes;
+                target->alignment = _alignment;
+            }
+            target->blocks[target->numBlocks++] = ptr;
+            return true;
+        }
+    };
+
+    // note: trivially destructible, so it can be read after the thread's cache has been destroyed
+    static bool& isThreadCacheDestroyed() noexcept
+    {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    // returns nullptr if the calling thread's cache has already been destroyed (thread/program exit)
+    static ThreadCache* getThreadCache() noexcept
+    {
+        if (isThreadCacheDestroyed())
+        {
+            return nullptr;
+        }
+        static thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    // moves the blocks of this pool cached by the given thread to the shared lists and unbinds them (note: the cache mutex must be locked)
+    void flushThreadCache(ThreadCache& cache) noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (ThreadCacheClass& cacheClass : cache.classes)
+        {
+            if (cacheClass.pool != this)
+            {
+                continue;
+            }
+            while (cacheClass.numBlocks > 0)
+            {
+                pushShared(cacheClass.blocks[--cacheClass.numBlocks], cacheClass.sizeInBytes, cacheClass.alignment);
+            }
+            cacheClass.pool = nullptr;
+        }
+    }
+
+    SizeClass* findSizeClass(size_t sizeInBytes, size_t alignment) noexcept
+    {
+        // note: there are only a few size classes (one per slot map type)
+        for (SizeClass& sizeClass : sizeClasses)
+        {
+            if (sizeClass.sizeInBytes == sizeInBytes && sizeClass.alignment == alignment)
+            {
+                return &sizeClass;
+            }
+        }
+        return nullptr;
+    }
+
+    // note: the mutex must be locked
+    void pushShared(void* ptr, size_t sizeInBytes, size_t alignment) noexcept
+    {
+        SizeClass* sizeClass = findSizeClass(sizeInBytes, alignment);
+        if (sizeClass == nullptr || sizeClass->blocks.size() == sizeClass->blocks.capacity())
+        {
+            // a block this pool didn't allocate (size class mismatch, counted in numSystemFrees), can't be cached without allocating
+            SLOT_MAP_FREE(ptr);
+            numSystemFrees.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        sizeClass->blocks.push_back(ptr);
+        cachedBytes += sizeInBytes;
+    }
+
+    mutable std::mutex mutex;
+    std::vector<SizeClass> sizeClasses;
+    size_t cachedBytes = 0;
+    std::atomic<uint64_t> numSystemAllocations{0};
+    std::atomic<uint64_t> numSystemFrees{0};
+    std::atomic<uint64_t> numReused{0};
+};
+
+} // namespace dod
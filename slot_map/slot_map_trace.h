@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#if !defined(SLOT_MAP_ASSERT)
+#include <assert.h>
+#define SLOT_MAP_ASSERT(expression) assert(expression)
+#endif
+
+/*
+  Slot map workload traces
+
+  A trace is a compact binary log of slot map operations that can be replayed against any configuration of the slot_map template
+  (see SlotMapReplay). Recording is enabled by defining SLOT_MAP_TRACE and attaching a recorder to a slot map instance:
+
+  ```
+  #define SLOT_MAP_TRACE
+  #include "slot_map.h"
+
+  FILE* f = fopen("workload.smtrace", "wb");
+  dod::slot_map_trace_recorder recorder(f);
+  slotMap.set_trace_recorder(&recorder);
+  ...
+  slotMap.set_trace_recorder(nullptr);
+  recorder.flush();
+  fclose(f);
+  ```
+
+  File format (little-endian)
+
+  | Field          |  Size                                  |
+  | ---------------|----------------------------------------|
+  | magic          |  4 ('SMTR')                            |
+  | version        |  2                                     |
+  | key size       |  1 (4 or 8 bytes)                      |
+  | reserved       |  1                                     |
+  | value size     |  4 (sizeof(T) of the recorded map)     |
+  | records...     |  1 (op) + key size (raw key)           |
+
+  Keys are recorded as raw numbers, replay maps every recorded key to the key returned by the replayed slot map.
+  Operations without a key (clear, reset, iterate) still store a zero key to keep all the records the same size.
+*/
+
+namespace dod
+{
+
+enum class slot_map_trace_op : uint8_t
+{
+    Emplace = 1, // key = returned key
+    Erase = 2,
+    Pop = 3,
+    Get = 4,
+    HasKey = 5,
+    Clear = 6,
+    Reset = 7,
+    IterateValues = 8,
+    IterateItems = 9,
+};
+
+struct slot_map_trace_header
+{
+    static inline constexpr uint8_t kMagic[4] = {'S', 'M', 'T', 'R'};
+    static inline constexpr uint16_t kVersion = 1;
+    static inline constexpr size_t kSizeInBytes = 12;
+
+    uint16_t version = kVersion;
+    uint8_t keySize = 0;
+    uint32_t valueSize = 0;
+};
+
+struct slot_map_trace_record
+{
+    slot_map_trace_op op;
+    uint64_t key;
+};
+
+/*
+  Records slot map operations into a fixed-capacity memory buffer and (optionally) flushes it into a file whenever the buffer is full
+
+  The buffer is allocated up front, so recording never allocates (it is called from noexcept functions like get and has_key).
+  Records that don't fit (no file, or the file write failed) are dropped and counted (see num_dropped_records).
+*/
+class slot_map_trace_recorder
+{
+  public:
+    // buffer capacity when recording into a file (flushed whenever it is full)
+    static inline constexpr size_t kFlushThreshold = 64 * 1024;
+    // buffer capacity when recording into memory (the whole trace has to fit)
+    static inline constexpr size_t kDefaultMemoryCapacity = 4 * 1024 * 1024;
+
+    // file = nullptr - keep the whole trace in memory (see data()), capacityInBytes = 0 - default capacity
+    explicit slot_map_trace_recorder(FILE* _file = nullptr, size_t capacityInBytes = 0)
+        : file(_file)
+        , keySize(0)
+    {
+        if (capacityInBytes == 0)
+        {
+            capacityInBytes = file ? kFlushThreshold : kDefaultMemoryCapacity;
+        }
+        // note: the header and at least one record always fit
+        buffer.reserve(std::max(capacityInBytes, slot_map_trace_header::kSizeInBytes + 1 + sizeof(uint64_t)));
+    }
+
+    slot_map_trace_recorder(const slot_map_trace_recorder&) = delete;
+    slot_map_trace_recorder& operator=(const slot_map_trace_recorder&) = delete;
+
+    ~slot_map_trace_recorder() { flush(); }
+
+    // writes the trace header (called by slot_map::set_trace_recorder)
+    void begin(uint8_t _keySize, uint32_t valueSize) noexcept
+    {
+        SLOT_MAP_ASSERT(_keySize == 4 || _keySize == 8);
+        if (keySize != 0)
+        {
+            // already started, all the records must use the same key size
+            SLOT_MAP_ASSERT(keySize == _keySize);
+            return;
+        }
+        keySize = _keySize;
+        SLOT_MAP_ASSERT(buffer.empty());
+        buffer.insert(buffer.end(), slot_map_trace_header::kMagic, slot_map_trace_header::kMagic + 4);
+        write(slot_map_trace_header::kVersion, 2);
+        write(keySize, 1);
+        write(0, 1);
+        write(valueSize, 4);
+    }
+
+    void record(slot_map_trace_op op, uint64_t rawKey) noexcept
+    {
+        SLOT_MAP_ASSERT(keySize != 0);
+        const size_t recordSize = 1 + size_t(keySize);
+        if (buffer.capacity() - buffer.size() < recordSize)
+        {
+            flush();
+            if (buffer.capacity() - buffer.size() < recordSize)
+            {
+                numDroppedRecords++;
+                return;
+            }
+        }
+        buffer.push_back(static_cast<uint8_t>(op));
+        write(rawKey, keySize);
+        numBufferedRecords++;
+    }
+
+    // writes the buffer into the file, returns false if any write has failed (the records of a failed write are dropped)
+    bool flush() noexcept
+    {
+        if (file == nullptr || buffer.empty())
+        {
+            return !writeFailed;
+        }
+        if (!writeFailed && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+        {
+            // note: the file ends with a partial record now, nothing is written after it
+            writeFailed = true;
+        }
+        if (writeFailed)
+        {
+            numDroppedRecords += numBufferedRecords;
+        }
+        buffer.clear();
+        numBufferedRecords = 0;
+        return !writeFailed;
+    }
+
+    // not yet flushed data (the whole trace if there is no file)
+    const std::vector<uint8_t>& data() const noexcept { return buffer; }
+
+    // records that have been lost (the in-memory buffer was full or the file write failed)
+    uint64_t num_dropped_records() const noexcept { return numDroppedRecords; }
+
+    // true if a file write has failed (the trace file is incomplete)
+    bool failed() const noexcept { return writeFailed; }
+
+  private:
+    // note: only called with enough room in the buffer (push_back never reallocates)
+    void write(uint64_t v, size_t numBytes) noexcept
+    {
+        for (size_t i = 0; i < numBytes; i++)
+        {
+            buffer.push_back(static_cast<uint8_t>((v >> (i * 8)) & 0xff));
+        }
+    }
+
+    FILE* file;
+    std::vector<uint8_t> buffer;
+    uint64_t numBufferedRecords = 0;
+    uint64_t numDroppedRecords = 0;
+    uint8_t keySize;
+    bool writeFailed = false;
+};
+
+/*
+  Parses a trace, returns false if the data is not a valid trace
+*/
+inline bool slot_map_trace_parse(const uint8_t* data, size_t size, slot_map_trace_header& header, std::vector<slot_map_trace_record>& records)
+{
+    auto read = [data](size_t offset, size_t numBytes) {
+        uint64_t v = 0;
+        for (size_t i = 0; i < numBytes; i++)
+        {
+            v |= static_cast<uint64_t>(data[offset + i]) << (i * 8);
+        }
+        return v;
+    };
+
+    if (size < slot_map_trace_header::kSizeInBytes)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (data[i] != slot_map_trace_header::kMagic[i])
+        {
+            return false;
+        }
+    }
+
+    header.version = static_cast<uint16_t>(read(4, 2));
+    header.keySize = static_cast<uint8_t>(read(6, 1));
+    header.valueSize = static_cast<uint32_t>(read(8, 4));
+    if (header.version != slot_map_trace_header::kVersion || (header.keySize != 4 && header.keySize != 8))
+    {
+        return false;
+    }
+
+    const size_t recordSize = 1 + size_t(header.keySize);
+    size_t payloadSize = size - slot_map_trace_header::kSizeInBytes;
+    if ((payloadSize % recordSize) != 0)
+    {
+        return false;
+    }
+
+    records.clear();
+    records.reserve(payloadSize / recordSize);
+    for (size_t offset = slot_map_trace_header::kSizeInBytes; offset < size; offset += recordSize)
+    {
+        uint8_t op = data[offset];
+        if (op < static_cast<uint8_t>(slot_map_trace_op::Emplace) || op > static_cast<uint8_t>(slot_map_trace_op::IterateItems))
+        {
+            return false;
+        }
+        records.push_back(slot_map_trace_record{static_cast<slot_map_trace_op>(op), read(offset + 1, header.keySize)});
+    }
+    return true;
+}
+
+} // namespace dod
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "slot_map.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SLOT_MAP_VM_SUPPORTED 1
+#else
+#define SLOT_MAP_VM_SUPPORTED 0
+#endif
+
+namespace dod
+{
+
+/*
+  Reserve-then-commit page allocator
+
+  Reserves a large virtual address range up front and commits it in allocation order (mmap PROT_NONE + mprotect),
+  so the pages of a slot map are packed into one range instead of being scattered by independent malloc calls.
+  Optionally backs the range with huge pages (explicit MAP_HUGETLB or transparent huge pages via madvise(MADV_HUGEPAGE)),
+  which removes most of the TLB misses of random `get` calls on big maps.
+  A page stays at its address while it is allocated (as with any page allocator), but there is no fixed page index to address mapping:
+  released pages are reused most recently released first, reclaimed/shrunk pages of a map come back at whatever address is free,
+  and several maps sharing the allocator interleave their pages. Lookups still go through the slot map's page table (one load).
+
+  ```
+  // 1 GB of address space, only the used pages are committed
+  dod::slot_map_vm_page_allocator vm(size_t(1) << 30, dod::slot_map_vm_page_allocator::kTransparentHugePages);
+  dod::slot_map64_page_bytes<Particle, 2 * 1024 * 1024> particles;
+  particles.set_page_allocator(&vm);
+  ```
+
+  Released pages stay committed and are reused by the next allocations of the same size.
+  Allocations that don't fit into the reserved range fall back to SLOT_MAP_ALLOC/SLOT_MAP_FREE.
+
+  Note: the allocator is not thread safe, use one allocator per slot map (or synchronize externally).
+  Note: the allocator must outlive all the pages allocated from it.
+  Note: on platforms without mmap every allocation falls back to SLOT_MAP_ALLOC/SLOT_MAP_FREE.
+*/
+class slot_map_vm_page_allocator : public slot_map_page_allocator
+{
+  public:
+    enum Flags : uint32_t
+    {
+        kNone = 0,
+        // madvise(MADV_HUGEPAGE) for the reserved range (Linux only)
+        kTransparentHugePages = 1 << 0,
+        // MAP_HUGETLB (Linux only, takes the whole range from the preallocated huge pages pool, falls back to regular pages)
+        kExplicitHugePages = 1 << 1,
+    };
+
+    static inline constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    struct Stats
+    {
+        size_t reservedBytes = 0;
+        size_t committedBytes = 0;
+        // bytes handed out from the reserved range (including released pages waiting for reuse)
+        size_t usedBytes = 0;
+        // allocations that didn't fit into the reserved range
+        uint64_t numFallbackAllocations = 0;
+        // pages of the reserved range released with a wrong size/alignment (or twice), their part of the range is never reused
+        uint64_t numLostPages = 0;
+        uint64_t numReused = 0;
+        // reserved range is backed by MAP_HUGETLB pages
+        bool explicitHugePages = false;
+    };
+
+    explicit slot_map_vm_page_allocator(size_t reserveBytes, uint32_t flags = kNone) { reserve(reserveBytes, flags); }
+
+    slot_map_vm_page_allocator(const slot_map_vm_page_allocator&) = delete;
+    slot_map_vm_page_allocator& operator=(const slot_map_vm_page_allocator&) = delete;
+
+    ~slot_map_vm_page_allocator() override
+    {
+#if SLOT_MAP_VM_SUPPORTED
+        if (mappedBase)
+        {
+            munmap(mappedBase, mappedSize);
+        }
+#endif
+    }
+
+    void* allocate_page(size_t sizeInBytes, size_t alignment) override
+    {
+        // reuse a released page of the same size class (most recently released first)
+        SizeClass* sizeClass = findSizeClass(sizeInBytes, alignment);
+        if (sizeClass && !sizeClass->freeBlocks.empty())
+        {
+            char* ptr = sizeClass->freeBlocks.back();
+            sizeClass->freeBlocks.pop_back();
+            numReused++;
+            return ptr;
+        }
+
+        size_t offset = (usedBytes + (alignment - 1)) & ~(alignment - 1);
+        if (base == nullptr || offset + sizeInBytes > reservedBytes || !commit(offset + sizeInBytes))
+        {
+            numFallbackAllocations++;
+            void* ptr = SLOT_MAP_ALLOC(sizeInBytes, alignment);
+            SLOT_MAP_ASSERT(ptr);
+            return ptr;
+        }
+
+        // note: reserve room for the page in the free list up front, so free_page never allocates
+        if (sizeClass == nullptr)
+        {
+            sizeClasses.push_back(SizeClass{sizeInBytes, alignment, {}, 0});
+            sizeClass = &sizeClasses.back();
+        }
+        if (sizeClass->freeBlocks.capacity() <= sizeClass->numAllocated)
+        {
+            sizeClass->freeBlocks.reserve(std::max(sizeClass->freeBlocks.capacity() * 2, size_t(8)));
+        }
+        sizeClass->numAllocated++;
+        usedBytes = offset + sizeInBytes;
+        return base + offset;
+    }
+
+    void free_page(void* ptr, size_t sizeInBytes, size_t alignment) noexcept override
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        if (!contains(ptr))
+        {
+            SLOT_MAP_FREE(ptr);
+            return;
+        }
+        // note: the page stays committed (no syscalls on page churn)
+        SizeClass* sizeClass = findSizeClass(sizeInBytes, alignment);
+        if (sizeClass == nullptr || sizeClass->freeBlocks.size() >= sizeClass->freeBlocks.capacity())
+        {
+            // a block that wasn't handed out with this size/alignment (or is released twice):
+            // pushing it would allocate (or hand out a wrong sized page), so its part of the range is lost
+            numLostPages++;
+            return;
+        }
+        sizeClass->freeBlocks.push_back(static_cast<char*>(ptr));
+    }
+
+    // returns true if the pointer belongs to the reserved range
+    bool contains(const void* ptr) const noexcept
+    {
+        const char* p = static_cast<const char*>(ptr);
+        return base != nullptr && p >= base && p < base + reservedBytes;
+    }
+
+    // start of the reserved range (nullptr if the reservation failed or is not supported)
+    const void* data() const noexcept { return base; }
+
+    Stats stats() const noexcept
+    {
+        Stats res;
+        res.reservedBytes = reservedBytes;
+        res.committedBytes = committedBytes;
+        res.usedBytes = usedBytes;
+        res.numFallbackAllocations = numFallbackAllocations;
+        res.numLostPages = numLostPages;
+        res.numReused = numReused;
+        res.explicitHugePages = explicitHugePages;
+        return res;
+    }
+
+  private:
+    // released pages of one size (and alignment), LIFO
+    struct SizeClass
+    {
+        size_t sizeInBytes;
+        size_t alignment;
+        // note: capacity is kept >= numAllocated, so releasing a page never allocates
+        std::vector<char*> freeBlocks;
+        // pages of this size class handed out from the reserved range
+        size_t numAllocated;
+    };
+
+    SizeClass* findSizeClass(size_t sizeInBytes, size_t alignment) noexcept
+    {
+        // note: there are only a few size classes (one per slot map type)
+        for (SizeClass& sizeClass : sizeClasses)
+        {
+            if (sizeClass.sizeInBytes == sizeInBytes && sizeClass.alignment == alignment)
+            {
+                return &sizeClass;
+            }
+        }
+        return nullptr;
+    }
+
+    void reserve([[maybe_unused]] size_t reserveBytes, [[maybe_unused]] uint32_t flags)
+    {
+#if SLOT_MAP_VM_SUPPORTED
+        const size_t osPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        commitGranularity = osPageSize;
+        if (flags & (kTransparentHugePages | kExplicitHugePages))
+        {
+            commitGranularity = kHugePageSize;
+        }
+        reserveBytes = (reserveBytes + (commitGranularity - 1)) & ~(commitGranularity - 1);
+        if (reserveBytes == 0)
+        {
+            return;
+        }
+
+#if defined(MAP_HUGETLB)
+        if (flags & kExplicitHugePages)
+        {
+            // note: no MAP_NORESERVE, touching a page that the hugetlb pool can't back raises SIGBUS,
+            // so the whole range is taken from the pool up front (mmap fails if there are not enough huge pages)
+            void* p = mmap(nullptr, reserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+            {
+                mappedBase = p;
+                mappedSize = reserveBytes;
+                base = static_cast<char*>(p);
+                reservedBytes = reserveBytes;
+                explicitHugePages = true;
+                return;
+            }
+        }
+#endif
+
+        // over-reserve to align the range to the commit granularity (huge pages have to be naturally aligned)
+        size_t padding = (commitGranularity > osPageSize) ? commitGranularity : 0;
+        void* p = mmap(nullptr, reserveBytes + padding, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            return;
+        }
+        mappedBase = p;
+        mappedSize = reserveBytes + padding;
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(p) + (commitGranularity - 1)) & ~(uintptr_t(commitGranularity) - 1);
+        base = reinterpret_cast<char*>(aligned);
+        reservedBytes = reserveBytes;
+#if defined(MADV_HUGEPAGE)
+        if (flags & kTransparentHugePages)
+        {
+            madvise(base, reservedBytes, MADV_HUGEPAGE);
+        }
+#endif
+#endif
+    }
+
+    // makes sure the first `numBytes` bytes of the reserved range are committed
+    bool commit([[maybe_unused]] size_t numBytes) noexcept
+    {
+        if (numBytes <= committedBytes)
+        {
+            return true;
+        }
+#if SLOT_MAP_VM_SUPPORTED
+        size_t newCommittedBytes = std::min((numBytes + (commitGranularity - 1)) & ~(commitGranularity - 1), reservedBytes);
+        if (mprotect(base + committedBytes, newCommittedBytes - committedBytes, PROT_READ | PROT_WRITE) != 0)
+        {
+            return false;
+        }
+        committedBytes = newCommittedBytes;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void* mappedBase = nullptr;
+    size_t mappedSize = 0;
+    char* base = nullptr;
+    size_t reservedBytes = 0;
+    size_t committedBytes = 0;
+    size_t usedBytes = 0;
+    size_t commitGranularity = 1;
+    std::vector<SizeClass> sizeClasses;
+    uint64_t numFallbackAllocations = 0;
+    uint64_t numLostPages = 0;
+    uint64_t numReused = 0;
+    bool explicitHugePages = false;
+};
+
+} // namespace dod
+
+#undef SLOT_MAP_VM_SUPPORTED
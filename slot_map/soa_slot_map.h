@@ -0,0 +1,631 @@
+#pragma once
+
+#include "slot_map.h"
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dod
+{
+
+/*
+  Contiguous range of component values (see soa_slot_map::page_component)
+*/
+template <typename T> struct slot_map_span
+{
+    T* ptr = nullptr;
+    size_t count = 0;
+
+    T* data() const noexcept { return ptr; }
+    size_t size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    T& operator[](size_t index) const noexcept
+    {
+        SLOT_MAP_ASSERT(index < count);
+        return ptr[index];
+    }
+    T* begin() const noexcept { return ptr; }
+    T* end() const noexcept { return ptr + count; }
+};
+
+template <typename T, typename TKeyType = slot_map_key64<T>, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64> class soa_slot_map;
+
+/*
+  Structure-of-arrays slot map
+
+  One key addresses several components (T = std::tuple<Ts...>). Every component is stored in its own contiguous array per page,
+  so a loop that touches one or two components doesn't drag whole records through the cache.
+
+  Keys, versions, free indices, page allocation and version overflow handling are exactly the same as in dod::slot_map
+  (the bookkeeping is done by a slot_map with an empty value type, see Slots).
+
+  Cost of the bookkeeping: every page is two allocations, the slot page of Slots (a 4 byte free list link and a live bit per slot,
+  16.5KB for a 4096 page) and the component block. get/has_key don't touch the slot page (versions live in the dense meta table),
+  but emplace/erase read or write the free list link, which is one more cache line per call. The link is not stored in the
+  component block because the free list is owned by the slot map (it is intrusive in its value storage).
+
+  Usage example:
+  ```
+  soa_slot_map<std::tuple<Position, Velocity, std::string>> entities;
+  auto e = entities.emplace(Position{0, 0}, Velocity{1, 0}, "player");
+
+  Position* pos = entities.get<0>(e);
+
+  // touches positions and velocities only
+  entities.for_each<0, 1>([](Position& p, const Velocity& v) { p += v; });
+
+  // vectorizable per-page loops
+  for (size_type page = 0; page < entities.num_pages(); page++)
+  {
+      auto positions = entities.page_component<0>(page);
+      auto velocities = entities.page_component<1>(page);
+      for (size_t i = 0; i < positions.size(); i++)
+      {
+          positions[i] += velocities[i];
+      }
+  }
+  ```
+
+  Note: page spans cover all the used slots of the page, including the slots that are not alive (see is_alive).
+  Component arrays are zero-filled on page allocation, so for trivially copyable components the slots that are not alive hold zeros
+  or stale values and are safe to read. Non-trivial components should only be accessed for alive slots.
+*/
+template <typename... Ts, typename TKeyType, size_t PAGESIZE, size_t MINFREEINDICES>
+class soa_slot_map<std::tuple<Ts...>, TKeyType, PAGESIZE, MINFREEINDICES>
+{
+    static_assert(sizeof...(Ts) > 0, "At least one component is required");
+
+    struct Slot
+    {
+    };
+
+    // dense meta layout: slot pages hold 4 bytes per slot (free list link), versions are stored in a separate table
+    using Slots = slot_map<Slot, TKeyType, PAGESIZE, MINFREEINDICES, slot_map_layout_dense_meta>;
+
+  public:
+    using key = TKeyType;
+    using version_t = typename Slots::version_t;
+    using index_t = typename Slots::index_t;
+    using tag_t = typename Slots::tag_t;
+    using size_type = typename Slots::size_type;
+    using Stats = typename Slots::Stats;
+
+    template <size_t I> using component_type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+    static inline constexpr size_type kPageSize = Slots::kPageSize;
+    static inline constexpr size_type kMinFreeIndices = Slots::kMinFreeIndices;
+    static inline constexpr size_t kNumComponents = sizeof...(Ts);
+
+    // every component array starts at a cache line boundary (aligned vector loads)
+    static inline constexpr size_t kComponentAlignment = std::max({size_t(64), alignof(Ts)...});
+
+  private:
+    static inline constexpr size_type kBitsPerWord = 64;
+    static inline constexpr size_type kNumBitmapWords = (kPageSize + kBitsPerWord - 1) / kBitsPerWord;
+
+    static constexpr size_t alignUp(size_t v, size_t alignment) noexcept { return (v + alignment - 1) & ~(alignment - 1); }
+
+    /*
+      Page memory: [component 0 * kPageSize][component 1 * kPageSize]...
+      offsets[kNumComponents] = page size in bytes
+    */
+    static constexpr std::array<size_t, kNumComponents + 1> getComponentOffsets() noexcept
+    {
+        constexpr size_t sizes[] = {sizeof(Ts)...};
+        std::array<size_t, kNumComponents + 1> offsets = {};
+        size_t offset = 0;
+        for (size_t i = 0; i < kNumComponents; i++)
+        {
+            offsets[i] = offset;
+            offset = alignUp(offset + sizes[i] * kPageSize, kComponentAlignment);
+        }
+        offsets[kNumComponents] = offset;
+        return offsets;
+    }
+
+    static inline constexpr std::array<size_t, kNumComponents + 1> kComponentOffsets = getComponentOffsets();
+    static inline constexpr size_t kPageSizeInBytes = kComponentOffsets[kNumComponents];
+
+    struct Page
+    {
+        void* rawMemory = nullptr;
+        // where the page memory came from (see slot_map::Page)
+        slot_map_page_allocator* allocator = nullptr;
+        std::pmr::memory_resource* resource = nullptr;
+        uint64_t liveBits[kNumBitmapWords] = {};
+        size_type numUsedElements = 0;
+        size_type numAliveSlots = 0;
+
+        bool isActive() const noexcept { return rawMemory != nullptr; }
+
+        template <size_t I> component_type<I>* component() const noexcept
+        {
+            SLOT_MAP_ASSERT(rawMemory);
+            return reinterpret_cast<component_type<I>*>(reinterpret_cast<char*>(rawMemory) + kComponentOffsets[I]);
+        }
+
+        bool isAlive(size_type index) const noexcept { return (liveBits[index / kBitsPerWord] & (uint64_t(1) << (index % kBitsPerWord))) != 0; }
+        void setAlive(size_type index) noexcept { liveBits[index / kBitsPerWord] |= (uint64_t(1) << (index % kBitsPerWord)); }
+        void setDead(size_type index) noexcept { liveBits[index / kBitsPerWord] &= ~(uint64_t(1) << (index % kBitsPerWord)); }
+
+        // note: the page allocator takes precedence over the memory resource
+        void allocate(slot_map_page_allocator* pageAllocator, std::pmr::memory_resource* memoryResource)
+        {
+            SLOT_MAP_ASSERT(!rawMemory);
+            if (pageAllocator)
+            {
+                rawMemory = pageAllocator->allocate_page(kPageSizeInBytes, kComponentAlignment);
+            }
+            else if (memoryResource)
+            {
+                rawMemory = memoryResource->allocate(kPageSizeInBytes, kComponentAlignment);
+            }
+            else
+            {
+                rawMemory = SLOT_MAP_ALLOC(kPageSizeInBytes, kComponentAlignment);
+            }
+            SLOT_MAP_ASSERT(rawMemory);
+            allocator = pageAllocator;
+            resource = pageAllocator ? nullptr : memoryResource;
+            std::memset(rawMemory, 0, kPageSizeInBytes);
+            std::memset(liveBits, 0, sizeof(liveBits));
+            numUsedElements = 0;
+            numAliveSlots = 0;
+        }
+
+        void deallocate() noexcept
+        {
+            if (!rawMemory)
+            {
+                return;
+            }
+            if (allocator)
+            {
+                allocator->free_page(rawMemory, kPageSizeInBytes, kComponentAlignment);
+            }
+            else if (resource)
+            {
+                resource->deallocate(rawMemory, kPageSizeInBytes, kComponentAlignment);
+            }
+            else
+            {
+                SLOT_MAP_FREE(rawMemory);
+            }
+            rawMemory = nullptr;
+            allocator = nullptr;
+            resource = nullptr;
+            numAliveSlots = 0;
+        }
+    };
+
+    template <typename FUNC> static void forEachAliveSlot(const Page& page, FUNC&& func)
+    {
+        for (size_type wordIndex = 0; wordIndex < kNumBitmapWords; wordIndex++)
+        {
+            uint64_t bits = page.liveBits[wordIndex];
+            while (bits != 0)
+            {
+                size_type elementIndex = wordIndex * kBitsPerWord + static_cast<size_type>(slot_map_count_trailing_zeros(bits));
+                bits &= bits - 1;
+                func(elementIndex);
+            }
+        }
+    }
+
+    /*
+      Destroys the first `numConstructed` components of a slot unless dismissed
+      (rolls back a partially constructed item if one of the component constructors throws)
+    */
+    struct ComponentsGuard
+    {
+        Page& page;
+        size_type index;
+        size_t numConstructed = 0;
+
+        ~ComponentsGuard() { destroyComponentsPrefix(page, index, numConstructed, std::index_sequence_for<Ts...>{}); }
+    };
+
+    template <size_t... Is, typename... Args> static void constructComponents(Page& page, size_type index, std::index_sequence<Is...>, Args&&... args)
+    {
+        ComponentsGuard guard{page, index};
+        ((new (reinterpret_cast<void*>(page.template component<Is>() + index)) Ts(std::forward<Args>(args)), guard.numConstructed++), ...);
+        guard.numConstructed = 0;
+    }
+
+    template <size_t... Is> static void destroyComponentsPrefix(Page& page, size_type index, size_t count, std::index_sequence<Is...>) noexcept
+    {
+        ((Is < count ? destroyComponent(page.template component<Is>() + index) : void()), ...);
+    }
+
+    template <size_t... Is> static void copyComponents(Page& page, const Page& otherPage, size_type index, std::index_sequence<Is...>)
+    {
+        (new (reinterpret_cast<void*>(page.template component<Is>() + index)) Ts(otherPage.template component<Is>()[index]), ...);
+    }
+
+    template <size_t... Is> static void destroyComponents(Page& page, size_type index, std::index_sequence<Is...>) noexcept
+    {
+        (destroyComponent(page.template component<Is>() + index), ...);
+    }
+
+    template <typename C> static void destroyComponent(C* p) noexcept
+    {
+        if constexpr (!std::is_trivially_destructible<C>::value)
+        {
+            p->~C();
+        }
+        else
+        {
+            (void)p;
+        }
+    }
+
+    Page* getPageByIndex(index_t index) noexcept
+    {
+        size_type pageIndex = static_cast<size_type>(index / kPageSize);
+        SLOT_MAP_ASSERT(pageIndex < pages.size());
+        return &pages[pageIndex];
+    }
+
+    // called by the slot map once all the slots of the page are deactivated (or on reset)
+    static void onSlotsPageRelease(const typename Slots::EventInfo& info, void* userData)
+    {
+        soa_slot_map* self = static_cast<soa_slot_map*>(userData);
+        if (info.pageIndex < self->pages.size())
+        {
+            Page& page = self->pages[info.pageIndex];
+            SLOT_MAP_ASSERT(page.numAliveSlots == 0);
+            page.deallocate();
+        }
+    }
+
+    void attachHooks() noexcept
+    {
+        hooks.onPageRelease = &onSlotsPageRelease;
+        hooks.userData = this;
+        slots.set_event_hooks(&hooks);
+    }
+
+    void destroyAll() noexcept
+    {
+        for (Page& page : pages)
+        {
+            if (!page.isActive())
+            {
+                continue;
+            }
+            forEachAliveSlot(page, [&](size_type elementIndex) { destroyComponents(page, elementIndex, std::index_sequence_for<Ts...>{}); });
+            std::memset(page.liveBits, 0, sizeof(page.liveBits));
+            page.numAliveSlots = 0;
+        }
+    }
+
+    void releaseAll() noexcept
+    {
+        destroyAll();
+        for (Page& page : pages)
+        {
+            page.deallocate();
+        }
+        pages.clear();
+    }
+
+    void copyFrom(const soa_slot_map& other)
+    {
+        pages.resize(other.pages.size());
+        for (size_t pageIndex = 0; pageIndex < other.pages.size(); pageIndex++)
+        {
+            const Page& otherPage = other.pages[pageIndex];
+            if (!otherPage.isActive())
+            {
+                continue;
+            }
+            Page& page = pages[pageIndex];
+            page.allocate(pageAllocator, getMemoryResource());
+            page.numUsedElements = otherPage.numUsedElements;
+            forEachAliveSlot(otherPage, [&](size_type elementIndex) {
+                copyComponents(page, otherPage, elementIndex, std::index_sequence_for<Ts...>{});
+                page.setAlive(elementIndex);
+                page.numAliveSlots++;
+            });
+        }
+    }
+
+    std::pmr::memory_resource* getMemoryResource() const noexcept { return pages.get_allocator().resource(); }
+
+    // erases the slot of an item that failed to construct (unless dismissed)
+    struct SlotGuard
+    {
+        Slots& slots;
+        key k;
+        bool dismissed = false;
+
+        ~SlotGuard()
+        {
+            if (!dismissed)
+            {
+                slots.erase(k);
+            }
+        }
+    };
+
+  public:
+    soa_slot_map()
+        : soa_slot_map(nullptr)
+    {
+    }
+
+    /*
+      Constructs an empty slot map that allocates all its memory (component pages, slot pages, version table)
+      from the given memory resource (nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE), see slot_map(std::pmr::memory_resource*).
+    */
+    explicit soa_slot_map(std::pmr::memory_resource* resource)
+        : slots(resource)
+        , pages(stl::Allocator<Page>(resource))
+    {
+        attachHooks();
+    }
+
+    ~soa_slot_map()
+    {
+        releaseAll();
+        slots.set_event_hooks(nullptr);
+    }
+
+    // copy constructor
+    soa_slot_map(const soa_slot_map& other)
+        : slots(other.slots)
+        , pages(stl::Allocator<Page>(other.getMemoryResource()))
+        , pageAllocator(other.pageAllocator)
+    {
+        attachHooks();
+        copyFrom(other);
+    }
+
+    // copy assignment
+    soa_slot_map& operator=(const soa_slot_map& other)
+    {
+        if (this != &other)
+        {
+            soa_slot_map tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    // move constructor
+    soa_slot_map(soa_slot_map&& other) noexcept
+        : slots(std::move(other.slots))
+        , pages(std::move(other.pages))
+        , pageAllocator(other.pageAllocator)
+    {
+        other.pages.clear();
+        attachHooks();
+        other.attachHooks();
+    }
+
+    // move asignment
+    soa_slot_map& operator=(soa_slot_map&& other) noexcept
+    {
+        reset();
+        swap(other);
+        return *this;
+    }
+
+    /*
+      Exchanges the content of the slot map by the content of another slot map object of the same type.
+    */
+    void swap(soa_slot_map& other) noexcept
+    {
+        slots.swap(other.slots);
+        pages.swap(other.pages);
+        std::swap(pageAllocator, other.pageAllocator);
+        // hooks follow the content on swap, re-attach them to the owners
+        attachHooks();
+        other.attachHooks();
+    }
+
+    /*
+      Constructs a new item, one argument per component.
+    */
+    template <class... Args> key emplace(Args&&... args)
+    {
+        static_assert(sizeof...(Args) == kNumComponents, "One argument per component is expected");
+
+        key k = slots.emplace();
+        // note: if anything below throws, the slot is erased (and the already constructed components are destroyed)
+        SlotGuard slotGuard{slots, k};
+        index_t index = key::toIndex(k);
+        size_type pageIndex = static_cast<size_type>(index / kPageSize);
+        size_type elementIndex = static_cast<size_type>(index % kPageSize);
+        if (pageIndex >= pages.size())
+        {
+            // note: slot indices grow sequentially, so only the last page could be new
+            pages.resize(static_cast<size_t>(pageIndex) + 1);
+        }
+
+        Page& page = pages[pageIndex];
+        if (!page.isActive())
+        {
+            page.allocate(pageAllocator, getMemoryResource());
+        }
+        SLOT_MAP_ASSERT(!page.isAlive(elementIndex));
+        constructComponents(page, elementIndex, std::index_sequence_for<Ts...>{}, std::forward<Args>(args)...);
+        slotGuard.dismissed = true;
+        page.setAlive(elementIndex);
+        page.numAliveSlots++;
+        page.numUsedElements = std::max(page.numUsedElements, static_cast<size_type>(elementIndex + 1));
+        return k;
+    }
+
+    /*
+      Returns true if the slot map contains a specific key
+    */
+    bool has_key(key k) const noexcept { return slots.has_key(k); }
+
+    /*
+      Returns a pointer to the I-th component of the item (or nullptr if the key is not valid).
+    */
+    template <size_t I> const component_type<I>* get(key k) const noexcept
+    {
+        if (!slots.has_key(k))
+        {
+            return nullptr;
+        }
+        index_t index = key::toIndex(k);
+        const Page& page = pages[static_cast<size_t>(index / kPageSize)];
+        SLOT_MAP_ASSERT(page.isAlive(static_cast<size_type>(index % kPageSize)));
+        return page.template component<I>() + (index % kPageSize);
+    }
+
+    template <size_t I> component_type<I>* get(key k) noexcept
+    {
+        return const_cast<component_type<I>*>(std::as_const(*this).template get<I>(k));
+    }
+
+    /*
+      Removes element (if such key exists) from the slot map.
+    */
+    void erase(key k)
+    {
+        if (!slots.has_key(k))
+        {
+            return;
+        }
+        index_t index = key::toIndex(k);
+        Page& page = *getPageByIndex(index);
+        size_type elementIndex = static_cast<size_type>(index % kPageSize);
+        SLOT_MAP_ASSERT(page.isAlive(elementIndex));
+        destroyComponents(page, elementIndex, std::index_sequence_for<Ts...>{});
+        page.setDead(elementIndex);
+        page.numAliveSlots--;
+
+        // note: could release the page (see onSlotsPageRelease)
+        slots.erase(k);
+    }
+
+    /*
+      Clears the slot map (keeps allocated pages, see slot_map::clear)
+    */
+    void clear()
+    {
+        destroyAll();
+        slots.clear();
+    }
+
+    /*
+      Clears the slot map and releases any allocated memory (see slot_map::reset)
+    */
+    void reset()
+    {
+        releaseAll();
+        slots.reset();
+    }
+
+    bool empty() const noexcept { return slots.empty(); }
+    size_type size() const noexcept { return slots.size(); }
+    Stats stats() const noexcept { return slots.stats(); }
+
+    /*
+      Sets the allocator for new pages (component pages and slot pages), see slot_map::set_page_allocator
+    */
+    void set_page_allocator(slot_map_page_allocator* allocator) noexcept
+    {
+        pageAllocator = allocator;
+        slots.set_page_allocator(allocator);
+    }
+    slot_map_page_allocator* get_page_allocator() const noexcept { return pageAllocator; }
+
+    /*
+      Returns the memory resource this slot map allocates from (nullptr = SLOT_MAP_ALLOC/SLOT_MAP_FREE)
+    */
+    std::pmr::memory_resource* get_memory_resource() const noexcept { return getMemoryResource(); }
+
+    /*
+      Number of pages (including released pages, see page_component)
+    */
+    size_type num_pages() const noexcept { return static_cast<size_type>(pages.size()); }
+
+    /*
+      Returns the I-th component array of the page (all the used slots of the page, alive or not)
+      Released pages return an empty span.
+    */
+    template <size_t I> slot_map_span<component_type<I>> page_component(size_type pageIndex) noexcept
+    {
+        SLOT_MAP_ASSERT(pageIndex < pages.size());
+        const Page& page = pages[pageIndex];
+        if (!page.isActive())
+        {
+            return {};
+        }
+        return slot_map_span<component_type<I>>{page.template component<I>(), page.numUsedElements};
+    }
+
+    template <size_t I> slot_map_span<const component_type<I>> page_component(size_type pageIndex) const noexcept
+    {
+        SLOT_MAP_ASSERT(pageIndex < pages.size());
+        const Page& page = pages[pageIndex];
+        if (!page.isActive())
+        {
+            return {};
+        }
+        return slot_map_span<const component_type<I>>{page.template component<I>(), page.numUsedElements};
+    }
+
+    /*
+      Returns true if the slot of the page holds a live item
+    */
+    bool is_alive(size_type pageIndex, size_type slotIndex) const noexcept
+    {
+        SLOT_MAP_ASSERT(pageIndex < pages.size());
+        SLOT_MAP_ASSERT(slotIndex < kPageSize);
+        const Page& page = pages[pageIndex];
+        return page.isActive() && page.isAlive(slotIndex);
+    }
+
+    /*
+      Calls `func(component<Is>&...)` for every live item, page by page (only the selected component arrays are touched)
+    */
+    template <size_t... Is, typename FUNC> void for_each(FUNC&& func)
+    {
+        static_assert(sizeof...(Is) > 0, "At least one component is expected");
+        for (Page& page : pages)
+        {
+            if (page.numAliveSlots == 0)
+            {
+                continue;
+            }
+            forEachAliveSlot(page, [&](size_type elementIndex) { func(page.template component<Is>()[elementIndex]...); });
+        }
+    }
+
+    template <size_t... Is, typename FUNC> void for_each(FUNC&& func) const
+    {
+        static_assert(sizeof...(Is) > 0, "At least one component is expected");
+        for (const Page& page : pages)
+        {
+            if (page.numAliveSlots == 0)
+            {
+                continue;
+            }
+            forEachAliveSlot(page, [&](size_type elementIndex) {
+                func(static_cast<const component_type<Is>&>(page.template component<Is>()[elementIndex])...);
+            });
+        }
+    }
+
+  private:
+    Slots slots;
+    std::vector<Page, stl::Allocator<Page>> pages;
+    typename Slots::EventHooks hooks;
+    slot_map_page_allocator* pageAllocator = nullptr;
+};
+
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
+using soa_slot_map32 = soa_slot_map<T, dod::slot_map_key32<T>, PAGESIZE, MINFREEINDICES>;
+
+template <class T, size_t PAGESIZE = 4096, size_t MINFREEINDICES = 64>
+using soa_slot_map64 = soa_slot_map<T, dod::slot_map_key64<T>, PAGESIZE, MINFREEINDICES>;
+
+} // namespace dod